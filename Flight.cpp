@@ -8,6 +8,9 @@
 
 #include "StratoPIB.h"
 
+// sends of the low power command from the error loop, to back off its resends
+static uint8_t error_lp_attempts = 0;
+
 // Flight mode states, FLA = autonomous, FLM = manual, FL = general
 enum FLStates_t : uint8_t {
     FL_ENTRY = MODE_ENTRY,
@@ -24,6 +27,7 @@ enum FLStates_t : uint8_t {
     FLM_PU_OFFLOAD,
     FLM_PROFILE,
     FLM_DOCKED,
+    FLM_SEQUENCE,
 
     // autonomous
     FLA_IDLE,
@@ -32,6 +36,7 @@ enum FLStates_t : uint8_t {
     FLA_PROFILE,
     FLA_PU_OFFLOAD,
     FLA_NOTE_PROFILE_END,
+    FLA_DEFERRED_OFFLOAD,
 
     // general off-nominal states
     FL_ERROR_LOOP,
@@ -68,19 +73,22 @@ void StratoPIB::FlightMode()
     case FL_ERROR_LANDING:
         log_error("Landed in flight error");
         scheduler.ClearSchedule();
+        timers.CancelAll();
+        ClearActions();
         mcb_motion_ongoing = false;
         profiles_remaining = 0;
         mcb_motion = NO_MOTION;
         mcbComm.TX_ASCII(MCB_GO_LOW_POWER);
-        scheduler.AddAction(RESEND_MCB_LP, MCB_RESEND_TIMEOUT);
+        error_lp_attempts = 0;
+        ScheduleResend(RESEND_MCB_LP, error_lp_attempts);
         mcb_low_power = false;
         inst_substate = FL_ERROR_LOOP;
         break;
     case FL_ERROR_LOOP:
         log_debug("FL error loop");
         if (!mcb_low_power && CheckAction(RESEND_MCB_LP)) {
-            scheduler.AddAction(RESEND_MCB_LP, MCB_RESEND_TIMEOUT);
-            mcbComm.TX_ASCII(MCB_GO_LOW_POWER); // just constantly send
+            ScheduleResend(RESEND_MCB_LP, error_lp_attempts);
+            mcbComm.TX_ASCII(MCB_GO_LOW_POWER); // just constantly send, backing off to the policy's cap
         }
 
         if (CheckAction(EXIT_ERROR_STATE)) {
@@ -156,6 +164,14 @@ void StratoPIB::ManualFlight()
             log_nominal("Docked profile");
             Flight_DockedProfile(true);
             inst_substate = FLM_DOCKED;
+        } else if (CheckAction(COMMAND_RUN_SEQUENCE)) {
+            log_nominal("Run uploaded sequence");
+            Flight_Sequence(true);
+            inst_substate = FLM_SEQUENCE;
+        } else if (CheckAction(ACTION_SEND_HK)) {
+            SendHousekeepingTM();
+        } else if (CheckAction(ACTION_SEND_LORA_STATUS)) {
+            SendLoRaStatusTM();
         }
         break;
 
@@ -163,8 +179,7 @@ void StratoPIB::ManualFlight()
         if (Flight_CheckPU(false)) {
             // only send status if the PU check succeeded (otherwise an error message will have been sent)
             if (check_pu_success) {
-                snprintf(log_array, LOG_ARRAY_SIZE, "PU status: %lu, %0.2f, %0.2f, %0.2f, %0.2f, %u", pu_status.time, pu_status.v_battery, pu_status.i_charge, pu_status.therm1, pu_status.therm2, pu_status.heater_stat);
-                ZephyrLogFine(log_array);
+                SendPUStatusTM();
             }
             inst_substate = FLM_IDLE;
         }
@@ -206,6 +221,12 @@ void StratoPIB::ManualFlight()
         }
         break;
 
+    case FLM_SEQUENCE:
+        if (Flight_Sequence(false)) {
+            inst_substate = FLM_IDLE;
+        }
+        break;
+
     default:
         log_error("Unknown manual substate");
         break;
@@ -216,14 +237,15 @@ void StratoPIB::AutonomousFlight()
 {
     switch (inst_substate) {
     case FLA_IDLE:
-        // reset profile schedule
-        if (zephyrRX.zephyr_gps.solar_zenith_angle < 45) {
+        // reset profile schedule (the calendar sets its own for the time trigger)
+        if (pibConfigs.sza_trigger.Read() && zephyrRX.zephyr_gps.solar_zenith_angle < 45) {
             profiles_remaining = pibConfigs.num_profiles.Read();
             profiles_scheduled = false;
         }
 
         // check for profiles or TSEN
-        if (0 != profiles_remaining && pibConfigs.sza_trigger.Read() && zephyrRX.zephyr_gps.solar_zenith_angle > pibConfigs.sza_minimum.Read()) {
+        if (0 != profiles_remaining && pibConfigs.sza_trigger.Read()
+            && (zephyrRX.zephyr_gps.solar_zenith_angle > pibConfigs.sza_minimum.Read() || SZATriggerPredicted())) {
             if (profiles_scheduled) {
                 inst_substate = FLA_WAIT_PROFILE;
             } else if (ScheduleProfiles()) { // Schedule Profiles sends result as TM
@@ -232,28 +254,45 @@ void StratoPIB::AutonomousFlight()
             } else {
                 inst_substate = FL_ERROR_LANDING;
             }
-        } else if (0 != profiles_remaining && !pibConfigs.sza_trigger.Read() && (uint32_t) now() >= pibConfigs.time_trigger.Read()) {
-            if (profiles_scheduled) {
-                inst_substate = FLA_WAIT_PROFILE;
-            } else if (ScheduleProfiles()) { // Schedule Profiles sends result as TM
+        } else if (!pibConfigs.sza_trigger.Read() && profiles_scheduled && 0 != profiles_remaining) {
+            // between the profiles of a calendar entry
+            inst_substate = FLA_WAIT_PROFILE;
+        } else if (!pibConfigs.sza_trigger.Read() && (uint32_t) now() >= NextCalendarTrigger()) {
+            if (ScheduleProfiles()) { // Schedule Profiles sends result as TM
                 profiles_scheduled = true;
                 inst_substate = FLA_WAIT_PROFILE;
             } else {
                 inst_substate = FL_ERROR_LANDING;
             }
+        } else if (offload_pending) {
+            // no profile followed to take the deferred offload, so perform it now
+            offload_pending = false;
+            Flight_PUOffload(true);
+            inst_substate = FLA_DEFERRED_OFFLOAD;
         } else if (CheckAction(COMMAND_SEND_TSEN)) {
             Flight_TSEN(true);
             inst_substate = FLA_TSEN;
+        } else if (CheckAction(ACTION_SEND_HK)) {
+            SendHousekeepingTM();
+        } else if (CheckAction(ACTION_SEND_LORA_STATUS)) {
+            SendLoRaStatusTM();
         }
         break;
 
     case FLA_WAIT_PROFILE:
-        if (CheckAction(ACTION_BEGIN_PROFILE)) {
+        // nothing was scheduled if no profile fit in the night, profiles_scheduled keeps it from rescheduling
+        if (0 == profiles_remaining) {
+            inst_substate = FLA_IDLE;
+        } else if (CheckAction(ACTION_BEGIN_PROFILE)) {
             Flight_Profile(true);
             inst_substate = FLA_PROFILE;
         } else if (CheckAction(COMMAND_SEND_TSEN)) {
             Flight_TSEN(true);
             inst_substate = FLA_TSEN;
+        } else if (CheckAction(ACTION_SEND_HK)) {
+            SendHousekeepingTM();
+        } else if (CheckAction(ACTION_SEND_LORA_STATUS)) {
+            SendLoRaStatusTM();
         }
         break;
 
@@ -265,8 +304,17 @@ void StratoPIB::AutonomousFlight()
 
     case FLA_PROFILE:
         if (Flight_Profile(false)) {
-            Flight_PUOffload(true);
-            inst_substate = FLA_PU_OFFLOAD;
+            if (profiles_remaining > 1 && !offload_pending) {
+                // the next profile offloads these records during its warmup
+                log_nominal("Deferring PU offload to next warmup");
+                offload_pending = true;
+                inst_substate = FLA_NOTE_PROFILE_END;
+            } else {
+                // last profile, or the previous records were never offloaded
+                offload_pending = false;
+                Flight_PUOffload(true);
+                inst_substate = FLA_PU_OFFLOAD;
+            }
         }
         break;
 
@@ -282,6 +330,12 @@ void StratoPIB::AutonomousFlight()
         inst_substate = FLA_IDLE;
         break;
 
+    case FLA_DEFERRED_OFFLOAD:
+        if (Flight_PUOffload(false)) {
+            inst_substate = FLA_IDLE;
+        }
+        break;
+
     default:
         log_error("Unknown autonomous substate");
         break;
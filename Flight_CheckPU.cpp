@@ -6,51 +6,47 @@
 
 #include "StratoPIB.h"
 
-enum CheckPUStates_t {
+enum CheckPUStates_t : uint8_t {
     ST_ENTRY,
-    ST_SEND_REQUEST,
     ST_WAIT_REQUEST,
+    NUM_CHECKPU_STATES
 };
 
-static CheckPUStates_t checkpu_state = ST_ENTRY;
-static bool resend_attempted = false;
+static const SMState_t checkpu_states[NUM_CHECKPU_STATES] = {
+    // next           resend action      failure message
+    {ST_WAIT_REQUEST, NO_ACTION,         NULL},  // ST_ENTRY
+    {ST_ENTRY,        RESEND_PU_CHECK,   "PU not responding to status request"},  // ST_WAIT_REQUEST
+};
+
+static PIBStateMachine<NUM_CHECKPU_STATES> checkpu_sm(checkpu_states);
 static uint32_t last_pu_status = 0;
 
 bool StratoPIB::Flight_CheckPU(bool restart_state)
 {
-    if (restart_state) checkpu_state = ST_ENTRY;
+    if (restart_state) checkpu_sm.Start(ST_ENTRY);
 
-    switch (checkpu_state) {
+    switch (checkpu_sm.State()) {
     case ST_ENTRY:
         log_nominal("Starting CheckPU Flight State");
-        resend_attempted = false;
         check_pu_success = false;
         last_pu_status = pu_status.last_status;
-        checkpu_state = ST_SEND_REQUEST;
-        break;
-
-    case ST_SEND_REQUEST:
-        puComm.TX_ASCII(PU_SEND_STATUS);
-        scheduler.AddAction(RESEND_PU_CHECK, PU_RESEND_TIMEOUT);
-        checkpu_state = ST_WAIT_REQUEST;
+        checkpu_sm.Next();
         break;
 
     case ST_WAIT_REQUEST:
-        if (last_pu_status != pu_status.last_status) {
-            resend_attempted = false;
-            check_pu_success = true;
-            return true;
+        if (checkpu_sm.Entered()) {
+            puComm.TX_ASCII(PU_SEND_STATUS);
+            ArmResend(checkpu_sm);
         }
 
-        if (CheckAction(RESEND_PU_CHECK)) {
-            if (!resend_attempted) {
-                resend_attempted = true;
-                checkpu_state = ST_SEND_REQUEST;
-            } else {
-                resend_attempted = false;
-                ZephyrLogWarn("PU not responding to status request");
-                return true;
-            }
+        switch (AwaitAck(checkpu_sm, last_pu_status != pu_status.last_status)) {
+        case SM_DONE:
+            check_pu_success = true;
+            return true;
+        case SM_FAILED:
+            return true;
+        default:
+            break;
         }
         break;
 
@@ -60,4 +56,4 @@ bool StratoPIB::Flight_CheckPU(bool restart_state)
     }
 
     return false; // assume incomplete
-}
\ No newline at end of file
+}
@@ -6,89 +6,76 @@
 
 #include "StratoPIB.h"
 
-enum ProfileStates_t {
-    ST_ENTRY,
-    ST_SET_PU_WARMUP,
-    ST_CONFIRM_PU_WARMUP,
+enum DockedProfileStates_t : uint8_t {
+    ST_PU_WARMUP,
     ST_WARMUP,
     ST_GET_TSEN,
-    ST_SET_PU_PREPROFILE,
-    ST_CONFIRM_PU_PREPROFILE,
+    ST_PU_PREPROFILE,
     ST_PREPROFILE_WAIT,
-    ST_GET_PU_STATUS,
+    NUM_DOCKEDPROFILE_STATES
 };
 
-static ProfileStates_t profile_state = ST_ENTRY;
-static bool resend_attempted = false;
+static const SMState_t dockedprofile_states[NUM_DOCKEDPROFILE_STATES] = {
+    // next              resend action        failure message
+    {ST_WARMUP,          RESEND_PU_WARMUP,    "PU not responding to warmup command"},  // ST_PU_WARMUP
+    {ST_GET_TSEN,        NO_ACTION,           NULL},  // ST_WARMUP
+    {ST_PU_PREPROFILE,   NO_ACTION,           NULL},  // ST_GET_TSEN
+    {ST_PREPROFILE_WAIT, RESEND_PU_GOPROFILE, "PU not responding to profile command"},  // ST_PU_PREPROFILE
+    {ST_PREPROFILE_WAIT, NO_ACTION,           NULL},  // ST_PREPROFILE_WAIT
+};
+
+static PIBStateMachine<NUM_DOCKEDPROFILE_STATES> dockedprofile_sm(dockedprofile_states);
 
 bool StratoPIB::Flight_DockedProfile(bool restart_state)
 {
-    if (restart_state) profile_state = ST_ENTRY;
-
-    switch (profile_state) {
-    case ST_ENTRY:
-    case ST_SET_PU_WARMUP:
-        pu_warmup = false;
-        puComm.TX_WarmUp(pibConfigs.flash_temp.Read(),pibConfigs.heater1_temp.Read(),pibConfigs.heater2_temp.Read(),
-                         pibConfigs.flash_power.Read(),pibConfigs.tsen_power.Read());
-        scheduler.AddAction(RESEND_PU_WARMUP, PU_RESEND_TIMEOUT);
-        profile_state = ST_CONFIRM_PU_WARMUP;
-        break;
+    if (restart_state) dockedprofile_sm.Start(ST_PU_WARMUP);
 
-    case ST_CONFIRM_PU_WARMUP:
-        if (pu_warmup) {
-            profile_state = ST_WARMUP;
-            scheduler.AddAction(ACTION_END_WARMUP, pibConfigs.puwarmup_time.Read());
-        } else if (CheckAction(RESEND_PU_WARMUP)) {
-            if (!resend_attempted) {
-                resend_attempted = true;
-                profile_state = ST_SET_PU_WARMUP;
-            } else {
-                resend_attempted = false;
-                ZephyrLogWarn("PU not responding to warmup command");
-                return true;
-            }
+    switch (dockedprofile_sm.State()) {
+    case ST_PU_WARMUP:
+        switch (AwaitPUWarmup(dockedprofile_sm)) {
+        case SM_DONE:
+            ScheduleTimer(ACTION_END_WARMUP, pibConfigs.puwarmup_time.Read());
+            dockedprofile_sm.Next();
+            break;
+        case SM_FAILED:
+            return true;
+        default:
+            break;
         }
         break;
 
     case ST_WARMUP:
         if (CheckAction(ACTION_END_WARMUP)) {
-            Flight_TSEN(true);
-            profile_state = ST_GET_TSEN;
+            dockedprofile_sm.Next();
         }
         break;
 
     case ST_GET_TSEN:
-        if (Flight_TSEN(false)) {
-            profile_state = ST_SET_PU_PREPROFILE;
+        if (dockedprofile_sm.Entered()) {
+            Flight_TSEN(true);
+        } else if (Flight_TSEN(false)) {
+            dockedprofile_sm.Next();
         }
         break;
 
-    case ST_SET_PU_PREPROFILE:
-        pu_preprofile = false;
-
-        // FIXME: replace the TX_PreProfile with a dedicated command, figure out data transmission
-        //LEK 8_2021: Just use the profile command to PU with short dwell and up times and LoRa off
-        pu_preprofile = puComm.TX_Profile(docked_profile_time-10, 5,5, pibConfigs.docked_rate.Read(), 1,pibConfigs.docked_TSEN.Read(),
-                             pibConfigs.docked_ROPC.Read(), pibConfigs.docked_FLASH.Read(),0);
-
-        scheduler.AddAction(RESEND_PU_GOPROFILE, PU_RESEND_TIMEOUT);
-        profile_state = ST_CONFIRM_PU_PREPROFILE;
-        break;
+    case ST_PU_PREPROFILE:
+        if (dockedprofile_sm.Entered()) {
+            // FIXME: replace the TX_PreProfile with a dedicated command, figure out data transmission
+            //LEK 8_2021: Just use the profile command to PU with short dwell and up times and LoRa off
+            pu_preprofile = puComm.TX_Profile(docked_profile_time-10, 5,5, pibConfigs.docked_rate.Read(), 1,pibConfigs.docked_TSEN.Read(),
+                                 pibConfigs.docked_ROPC.Read(), pibConfigs.docked_FLASH.Read(),0);
+            ArmResend(dockedprofile_sm);
+        }
 
-    case ST_CONFIRM_PU_PREPROFILE:
-        if (pu_preprofile) {
-            profile_state = ST_PREPROFILE_WAIT;
-            scheduler.AddAction(ACTION_END_PREPROFILE, docked_profile_time);
-        } else if (CheckAction(RESEND_PU_GOPROFILE)) {
-            if (!resend_attempted) {
-                resend_attempted = true;
-                profile_state = ST_SET_PU_PREPROFILE;
-            } else {
-                resend_attempted = false;
-                ZephyrLogWarn("PU not responding to profile command");
-                return true;
-            }
+        switch (AwaitAck(dockedprofile_sm, pu_preprofile)) {
+        case SM_DONE:
+            ScheduleTimer(ACTION_END_PREPROFILE, docked_profile_time);
+            dockedprofile_sm.Next();
+            break;
+        case SM_FAILED:
+            return true;
+        default:
+            break;
         }
         break;
 
@@ -111,4 +98,4 @@ bool StratoPIB::Flight_DockedProfile(bool restart_state)
     }
 
     return false; // assume incomplete
-}
\ No newline at end of file
+}
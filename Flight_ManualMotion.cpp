@@ -6,93 +6,59 @@
 
 #include "StratoPIB.h"
 
-enum ManualMotionStates_t {
-    ST_ENTRY,
-    ST_SEND_RA,
-    ST_WAIT_RAACK,
+enum ManualMotionStates_t : uint8_t {
+    ST_WAIT_RA,
     ST_START_MOTION,
-    ST_VERIFY_MOTION,
     ST_MONITOR_MOTION,
     ST_TM_ACK,
+    NUM_MANUALMOTION_STATES
 };
 
-static ManualMotionStates_t manualmotion_state = ST_ENTRY;
-static bool resend_attempted = false;
+static const SMState_t manualmotion_states[NUM_MANUALMOTION_STATES] = {
+    // next             resend action          failure message
+    {ST_START_MOTION,   RESEND_RA,             "Never received RAAck"},  // ST_WAIT_RA
+    {ST_MONITOR_MOTION, RESEND_MOTION_COMMAND, "MCB never confirmed motion"},  // ST_START_MOTION
+    {ST_TM_ACK,         NO_ACTION,             NULL},  // ST_MONITOR_MOTION
+    {ST_TM_ACK,         RESEND_TM,             NULL},  // ST_TM_ACK
+};
+
+static PIBStateMachine<NUM_MANUALMOTION_STATES> manualmotion_sm(manualmotion_states);
 
 bool StratoPIB::Flight_ManualMotion(bool restart_state)
 {
-    if (restart_state) manualmotion_state = ST_ENTRY;
+    if (restart_state) manualmotion_sm.Start(ST_WAIT_RA);
 
-    switch (manualmotion_state) {
-    case ST_ENTRY:
-    case ST_SEND_RA:
-        RA_ack_flag = NO_ACK;
-        zephyrTX.RA();
-        manualmotion_state = ST_WAIT_RAACK;
-        scheduler.AddAction(RESEND_RA, ZEPHYR_RESEND_TIMEOUT);
-        log_nominal("Sending RA");
-        break;
-
-    case ST_WAIT_RAACK:
-        if(pibConfigs.ra_override.Read()) //Over Ride RA requirement in an emergency
-            RA_ack_flag = ACK;
-        if (ACK == RA_ack_flag) {
-            manualmotion_state = ST_START_MOTION;
-            resend_attempted = false;
-            log_nominal("RA ACK");
-        } else if (NAK == RA_ack_flag) {
-            resend_attempted = false;
-            ZephyrLogWarn("Cannot perform motion, RA NAK");
+    switch (manualmotion_sm.State()) {
+    case ST_WAIT_RA:
+        switch (AwaitRA(manualmotion_sm)) {
+        case SM_DONE:
+            manualmotion_sm.Next();
+            break;
+        case SM_FAILED:
             return true;
-        } else if (CheckAction(RESEND_RA)) {
-            if (!resend_attempted) {
-                resend_attempted = true;
-                manualmotion_state = ST_SEND_RA;
-            } else {
-                ZephyrLogWarn("Never received RAAck");
-                resend_attempted = false;
-                return true;
-            }
+        default:
+            break;
         }
         break;
 
     case ST_START_MOTION:
-        if (mcb_motion_ongoing) {
-            ZephyrLogWarn("Motion commanded while motion ongoing");
-            inst_substate = MODE_ERROR; // will force exit of Flight_Profile
-        }
-
-        if (StartMCBMotion()) {
-            manualmotion_state = ST_VERIFY_MOTION;
-            scheduler.AddAction(RESEND_MOTION_COMMAND, MCB_RESEND_TIMEOUT);
-        } else {
-            ZephyrLogWarn("Motion start error");
+        switch (AwaitMotionStart(manualmotion_sm)) {
+        case SM_DONE:
+            ScheduleTimer(ACTION_MOTION_TIMEOUT, max_profile_seconds);
+            manualmotion_sm.Next();
+            break;
+        case SM_FAILED:
             inst_substate = MODE_ERROR; // will force exit of Flight_Profile
-        }
-        break;
-
-    case ST_VERIFY_MOTION:
-        if (mcb_motion_ongoing) { // set in the Ack handler
-            log_nominal("MCB commanded motion");
-            scheduler.AddAction(ACTION_MOTION_TIMEOUT, max_profile_seconds);
-            manualmotion_state = ST_MONITOR_MOTION;
-        }
-
-        if (CheckAction(RESEND_MOTION_COMMAND)) {
-            if (!resend_attempted) {
-                resend_attempted = true;
-                manualmotion_state = ST_START_MOTION;
-            } else {
-                resend_attempted = false;
-                ZephyrLogWarn("MCB never confirmed motion");
-                inst_substate = MODE_ERROR; // will force exit of Flight_Profile
-            }
+            break;
+        default:
+            break;
         }
         break;
 
     case ST_MONITOR_MOTION:
         if (CheckAction(ACTION_MOTION_STOP)) {
             // todo: verification of motion stop
+            CancelTimer(ACTION_MOTION_TIMEOUT);
             ZephyrLogFine("Commanded motion stop");
             return true;
             break;
@@ -105,22 +71,23 @@ bool StratoPIB::Flight_ManualMotion(bool restart_state)
             break;
         }
 
+        if (HandleMotionStall()) break;
+
         if (!mcb_motion_ongoing) {
             SendMCBTM(FINE, "Finished commanded manual motion");
-            manualmotion_state = ST_TM_ACK;
-            scheduler.AddAction(RESEND_TM, ZEPHYR_RESEND_TIMEOUT);
+            manualmotion_sm.Next();
         }
         break;
 
     case ST_TM_ACK:
-        if (ACK == TM_ack_flag) {
+        switch (AwaitTMAck(manualmotion_sm)) {
+        case SM_DONE:
             log_nominal("Zephyr ACKed motion TM");
             return true;
-        } else if (NAK == TM_ack_flag || CheckAction(RESEND_TM)) {
-            // attempt one resend
-            log_error("Needed to resend TM");
-            zephyrTX.TM(); // message is still saved in XMLWriter, no need to reconstruct
+        case SM_FAILED:
             return true;
+        default:
+            break;
         }
         break;
 
@@ -130,4 +97,4 @@ bool StratoPIB::Flight_ManualMotion(bool restart_state)
     }
 
     return false; // assume incomplete
-}
\ No newline at end of file
+}
@@ -6,87 +6,91 @@
 
 #include "StratoPIB.h"
 
-enum PUOffloadStates_t {
+enum PUOffloadStates_t : uint8_t {
     ST_ENTRY,
     ST_GET_PU_STATUS,
-    ST_WAIT_PU_STATUS,
-    ST_REQUEST_PACKET,
     ST_WAIT_PACKET,
     ST_TM_ACK,
+    NUM_PUOFFLOAD_STATES
 };
 
-static PUOffloadStates_t puoffload_state = ST_ENTRY;
-static bool resend_attempted = false;
+static const SMState_t puoffload_states[NUM_PUOFFLOAD_STATES] = {
+    // next            resend action     failure message
+    {ST_GET_PU_STATUS, NO_ACTION,        NULL},  // ST_ENTRY
+    {ST_WAIT_PACKET,   NO_ACTION,        NULL},  // ST_GET_PU_STATUS
+    {ST_TM_ACK,        RESEND_PU_RECORD, "PU not successful in sending profile record"},  // ST_WAIT_PACKET
+    {ST_GET_PU_STATUS, RESEND_TM,        NULL},  // ST_TM_ACK
+};
+
+static PIBStateMachine<NUM_PUOFFLOAD_STATES> puoffload_sm(puoffload_states);
 static uint8_t packet_num = 0;
 
 bool StratoPIB::Flight_PUOffload(bool restart_state)
 {
-    if (restart_state) puoffload_state = ST_ENTRY;
+    if (restart_state) {
+        offload_yield = false;
+        puoffload_sm.Start(ST_ENTRY);
+    }
 
-    switch (puoffload_state) {
+    switch (puoffload_sm.State()) {
     case ST_ENTRY:
-        resend_attempted = false;
         packet_num = 0;
-        puoffload_state = ST_GET_PU_STATUS;
+        puoffload_sm.Next();
         break;
 
     case ST_GET_PU_STATUS:
-        Flight_CheckPU(true);
-        puoffload_state = ST_WAIT_PU_STATUS;
+        if (puoffload_sm.Entered()) {
+            // between records, so the caller can stop here and finish later
+            if (offload_yield) {
+                log_nominal("PU offload stopped with records remaining");
+                return true;
+            }
+            Flight_CheckPU(true);
+        } else if (Flight_CheckPU(false)) {
+            puoffload_sm.Next();
+        }
         break;
 
-    case ST_WAIT_PU_STATUS:
-        if (Flight_CheckPU(false)) {
-            puoffload_state = ST_REQUEST_PACKET;
+    case ST_WAIT_PACKET:
+        if (puoffload_sm.Entered()) {
+            record_received = false;
+            pu_no_more_records = false;
+            puComm.TX_ASCII(PU_SEND_PROFILE_RECORD);
+            ArmResend(puoffload_sm);
         }
-        break;
 
-    case ST_REQUEST_PACKET:
-        puComm.TX_ASCII(PU_SEND_PROFILE_RECORD);
-        scheduler.AddAction(RESEND_PU_RECORD, PU_RESEND_TIMEOUT);
-        record_received = false;
-        pu_no_more_records = false;
-        puoffload_state = ST_WAIT_PACKET;
-        break;
+        if (pu_no_more_records) {
+            pu_no_more_records = false;
+            offload_yield = false;
+            CancelTimer(RESEND_PU_RECORD);
+            log_nominal("No more profile records");
+            return true;
+        }
 
-    case ST_WAIT_PACKET:
-        if (record_received) { // ACK/NAK in PURouter
+        switch (AwaitAck(puoffload_sm, record_received)) { // ACK/NAK in PURouter
+        case SM_DONE:
             record_received = false;
             packet_num++;
             snprintf(log_array, LOG_ARRAY_SIZE, "Received profile record: %u", puComm.binary_rx.bin_length);
             log_nominal(log_array);
             SendProfileTM(packet_num);
-            puoffload_state = ST_TM_ACK;
-            scheduler.AddAction(RESEND_TM, ZEPHYR_RESEND_TIMEOUT);
+            puoffload_sm.Next();
             break;
-        } else if (pu_no_more_records) {
-            pu_no_more_records = false;
-            log_nominal("No more profile records");
+        case SM_FAILED:
             return true;
-        }
-
-        if (CheckAction(RESEND_PU_RECORD)) {
-            if (!resend_attempted) {
-                resend_attempted = true;
-                puoffload_state = ST_REQUEST_PACKET;
-            } else {
-                resend_attempted = false;
-                ZephyrLogWarn("PU not successful in sending profile record");
-                return true;
-            }
+        default:
+            break;
         }
         break;
 
     case ST_TM_ACK:
-        if (ACK == TM_ack_flag) {
-            resend_attempted = false;
-            puoffload_state = ST_GET_PU_STATUS;
-        } else if (NAK == TM_ack_flag || CheckAction(RESEND_TM)) {
-            // attempt one resend
-            log_error("Needed to resend TM");
-            zephyrTX.TM(); // message is still saved in XMLWriter, no need to reconstruct
-            resend_attempted = false;
-            puoffload_state = ST_GET_PU_STATUS;
+        switch (AwaitTMAck(puoffload_sm)) {
+        case SM_DONE:
+        case SM_FAILED:
+            puoffload_sm.Next();
+            break;
+        default:
+            break;
         }
         break;
 
@@ -96,4 +100,4 @@ bool StratoPIB::Flight_PUOffload(bool restart_state)
     }
 
     return false; // assume incomplete
-}
\ No newline at end of file
+}
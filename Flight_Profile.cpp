@@ -6,190 +6,222 @@
 
 #include "StratoPIB.h"
 
-enum ProfileStates_t {
-    ST_ENTRY,
-    ST_SEND_RA,
-    ST_WAIT_RAACK,
-    ST_HOUSKEEPING_CHECK,
-    ST_SET_PU_WARMUP,
-    ST_CONFIRM_PU_WARMUP,
-    ST_WARMUP,
+enum ProfileStates_t : uint8_t {
+    ST_PREP,
     ST_GET_TSEN,
-    ST_SET_PU_PROFILE,
-    ST_CONFIRM_PU_PROFILE,
+    ST_WARMUP,
+    ST_PU_PROFILE,
     ST_PREPROFILE_WAIT,
-    ST_REEL_OUT,
+    ST_LEG,
     ST_DWELL,
-    ST_REEL_IN,
     ST_DOCK_WAIT,
     ST_DOCK,
     ST_GET_PU_STATUS,
     ST_VERIFY_DOCK,
     ST_REDOCK,
     ST_START_MOTION,
-    ST_VERIFY_MOTION,
     ST_MONITOR_MOTION,
     ST_CONFIRM_MCB_LP,
+    NUM_PROFILE_STATES
+};
+
+static const SMState_t profile_states[NUM_PROFILE_STATES] = {
+    // next             resend action          failure message
+    {ST_GET_TSEN,       NO_ACTION,             NULL},  // ST_PREP
+    {ST_WARMUP,         NO_ACTION,             NULL},  // ST_GET_TSEN
+    {ST_PU_PROFILE,     NO_ACTION,             NULL},  // ST_WARMUP
+    {ST_PREPROFILE_WAIT, RESEND_PU_GOPROFILE,  "PU not responding to profile command"},  // ST_PU_PROFILE
+    {ST_LEG,            NO_ACTION,             NULL},  // ST_PREPROFILE_WAIT
+    {ST_START_MOTION,   NO_ACTION,             NULL},  // ST_LEG
+    {ST_LEG,            NO_ACTION,             NULL},  // ST_DWELL
+    {ST_DOCK,           NO_ACTION,             NULL},  // ST_DOCK_WAIT
+    {ST_START_MOTION,   NO_ACTION,             NULL},  // ST_DOCK
+    {ST_VERIFY_DOCK,    NO_ACTION,             NULL},  // ST_GET_PU_STATUS
+    {ST_CONFIRM_MCB_LP, NO_ACTION,             NULL},  // ST_VERIFY_DOCK
+    {ST_GET_PU_STATUS,  NO_ACTION,             NULL},  // ST_REDOCK
+    {ST_MONITOR_MOTION, RESEND_MOTION_COMMAND, "MCB never confirmed motion"},  // ST_START_MOTION
+    {ST_MONITOR_MOTION, NO_ACTION,             NULL},  // ST_MONITOR_MOTION
+    {ST_CONFIRM_MCB_LP, RESEND_MCB_LP,         "MCB never powered off after profile"},  // ST_CONFIRM_MCB_LP
 };
 
-static ProfileStates_t profile_state = ST_ENTRY;
-static bool resend_attempted = false;
+// the RA handshake and PU warmup run side by side during ST_PREP, each on its own machine
+enum PrepStates_t : uint8_t {
+    ST_PREP_AWAIT,
+    ST_PREP_DONE,
+    NUM_PREP_STATES
+};
+
+static const SMState_t prep_ra_states[NUM_PREP_STATES] = {
+    {ST_PREP_DONE,      RESEND_RA,             "Never received RAAck"},  // ST_PREP_AWAIT
+    {ST_PREP_DONE,      NO_ACTION,             NULL},  // ST_PREP_DONE
+};
+
+static const SMState_t prep_warmup_states[NUM_PREP_STATES] = {
+    {ST_PREP_DONE,      RESEND_PU_WARMUP,      "PU not responding to warmup command"},  // ST_PREP_AWAIT
+    {ST_PREP_DONE,      NO_ACTION,             NULL},  // ST_PREP_DONE
+};
+
+static PIBStateMachine<NUM_PROFILE_STATES> profile_sm(profile_states);
+static PIBStateMachine<NUM_PREP_STATES> prep_ra_sm(prep_ra_states);
+static PIBStateMachine<NUM_PREP_STATES> prep_warmup_sm(prep_warmup_states);
 static uint8_t redock_count = 0;
+static bool warmup_complete = false;
+static uint16_t dwell = 0;
 
 bool StratoPIB::Flight_Profile(bool restart_state)
 {
-    if (restart_state) profile_state = ST_ENTRY;
-
-    switch (profile_state) {
-    case ST_ENTRY:
-    case ST_SEND_RA:
-        RA_ack_flag = NO_ACK;
-        zephyrTX.RA();
-        profile_state = ST_WAIT_RAACK;
-        scheduler.AddAction(RESEND_RA, ZEPHYR_RESEND_TIMEOUT);
-        log_nominal("Sending RA");
-        break;
+    if (restart_state) profile_sm.Start(ST_PREP);
+
+    switch (profile_sm.State()) {
+    case ST_PREP:
+        // warmup doesn't depend on the RA, so request both at once and join once both are acknowledged
+        if (profile_sm.Entered()) {
+            warmup_complete = false;
+            prep_ra_sm.Start(ST_PREP_AWAIT);
+            prep_warmup_sm.Start(ST_PREP_AWAIT);
+        }
 
-    case ST_WAIT_RAACK:
-        if(pibConfigs.ra_override.Read()) //Over Ride RA requirement in an emergency or for testing
-            RA_ack_flag = ACK; 
-        log_debug("FLA wait RA Ack");
-        if (ACK == RA_ack_flag) {
-            profile_state = ST_HOUSKEEPING_CHECK;
-            resend_attempted = false;
-            log_nominal("RA ACK");
-        } else if (NAK == RA_ack_flag) {
-            ZephyrLogWarn("Cannot perform motion, RA NAK");
-            resend_attempted = false;
-            return true;
-        } else if (CheckAction(RESEND_RA)) {
-            if (!resend_attempted) {
-                resend_attempted = true;
-                profile_state = ST_SEND_RA;
-            } else {
-                ZephyrLogWarn("Never received RAAck");
-                resend_attempted = false;
+        if (CheckAction(ACTION_END_WARMUP)) warmup_complete = true;
+
+        if (ST_PREP_AWAIT == prep_ra_sm.State()) {
+            log_debug("FLA wait RA Ack");
+            switch (AwaitRA(prep_ra_sm)) {
+            case SM_DONE:
+                prep_ra_sm.Next();
+                break;
+            case SM_FAILED:
+                // no permission to move, the PU was already told to warm up so send it back to idle
+                CancelTimer(RESEND_PU_WARMUP);
+                CancelTimer(ACTION_END_WARMUP);
+                puComm.TX_ASCII(PU_RESET);
+                log_nominal("Profile aborted before motion, PU reset from warmup");
                 return true;
+            default:
+                break;
             }
         }
-        break;
 
-    case ST_HOUSKEEPING_CHECK:
-        profile_state = ST_SET_PU_WARMUP;
-        resend_attempted = false;
-        break;
-
-    case ST_SET_PU_WARMUP:
-        pu_warmup = false;
-        puComm.TX_WarmUp(pibConfigs.flash_temp.Read(),pibConfigs.heater1_temp.Read(),pibConfigs.heater2_temp.Read(),
-                         pibConfigs.flash_power.Read(),pibConfigs.tsen_power.Read());
-        scheduler.AddAction(RESEND_PU_WARMUP, PU_RESEND_TIMEOUT);
-        profile_state = ST_CONFIRM_PU_WARMUP;
-        break;
-
-    case ST_CONFIRM_PU_WARMUP:
-        if (pu_warmup) {
-            profile_state = ST_WARMUP;
-            scheduler.AddAction(ACTION_END_WARMUP, pibConfigs.puwarmup_time.Read());
-        } else if (CheckAction(RESEND_PU_WARMUP)) {
-            if (!resend_attempted) {
-                resend_attempted = true;
-                profile_state = ST_SET_PU_WARMUP;
-            } else {
-                resend_attempted = false;
-                ZephyrLogWarn("PU not responding to warmup command");
+        if (ST_PREP_AWAIT == prep_warmup_sm.State()) {
+            switch (AwaitPUWarmup(prep_warmup_sm)) {
+            case SM_DONE:
+                ScheduleTimer(ACTION_END_WARMUP, pibConfigs.puwarmup_time.Read());
+                prep_warmup_sm.Next();
+                break;
+            case SM_FAILED:
+                CancelTimer(RESEND_RA);
                 return true;
+            default:
+                break;
             }
         }
-        break;
 
-    case ST_WARMUP:
-        if (CheckAction(ACTION_END_WARMUP)) {
-            Flight_TSEN(true);
-            profile_state = ST_GET_TSEN;
+        if (ST_PREP_DONE == prep_ra_sm.State() && ST_PREP_DONE == prep_warmup_sm.State()) {
+            profile_sm.Next();
         }
         break;
 
     case ST_GET_TSEN:
-        if (Flight_TSEN(false)) {
-            profile_state = ST_SET_PU_PROFILE;
+        // drain the TSEN backlog while the PU warms up
+        if (CheckAction(ACTION_END_WARMUP)) warmup_complete = true;
+
+        if (profile_sm.Entered()) {
+            Flight_TSEN(true);
+        } else if (Flight_TSEN(false)) {
+            profile_sm.Next();
         }
         break;
 
-    case ST_SET_PU_PROFILE:
-        retract_length = pibConfigs.profile_size.Read() - pibConfigs.dock_amount.Read();
-        deploy_length = pibConfigs.profile_size.Read();
-        dock_length = pibConfigs.dock_amount.Read() + pibConfigs.dock_overshoot.Read();
-        pu_profile = false;
-        PUStartProfile();
-        scheduler.AddAction(RESEND_PU_GOPROFILE, PU_RESEND_TIMEOUT);
-        profile_state = ST_CONFIRM_PU_PROFILE;
+    case ST_WARMUP:
+        if (CheckAction(ACTION_END_WARMUP)) warmup_complete = true;
+
+        // offload the previous profile's records in the rest of the warmup window, once the warmup
+        // ends the offload stops at the next record and any left are offloaded after the profile
+        if (offload_pending) {
+            if (profile_sm.Entered()) {
+                log_nominal("Offloading previous profile during warmup");
+                Flight_PUOffload(true);
+            } else {
+                if (warmup_complete) offload_yield = true;
+                if (Flight_PUOffload(false)) offload_pending = offload_yield;
+            }
+            break;
+        }
+
+        if (warmup_complete) {
+            profile_sm.Next();
+        }
         break;
 
-    case ST_CONFIRM_PU_PROFILE:
-        if (pu_profile) {
-            profile_state = ST_PREPROFILE_WAIT;
-            scheduler.AddAction(ACTION_END_PREPROFILE, pibConfigs.preprofile_time.Read());
-        } else if (CheckAction(RESEND_PU_GOPROFILE)) {
-            if (!resend_attempted) {
-                resend_attempted = true;
-                profile_state = ST_SET_PU_PROFILE;
-            } else {
-                resend_attempted = false;
-                ZephyrLogWarn("PU not responding to profile command");
-                return true;
+    case ST_PU_PROFILE:
+        if (profile_sm.Entered()) {
+            num_legs = BuildProfilePlan(profile_legs);
+            leg_index = 0;
+            if (num_legs > 2) {
+                // casts, stops, or velocity bands in use
+                snprintf(log_array, LOG_ARRAY_SIZE, "Profile plan: %u legs, %lu s of motion and dwell", num_legs, PlanSeconds(profile_legs, 0, num_legs));
+                ZephyrLogFine(log_array);
             }
+            dock_length = pibConfigs.dock_amount.Read() + pibConfigs.dock_overshoot.Read();
+            pu_profile = false;
+            PUStartProfile();
+            ArmResend(profile_sm);
+        }
+
+        switch (AwaitAck(profile_sm, pu_profile)) {
+        case SM_DONE:
+            ScheduleTimer(ACTION_END_PREPROFILE, pibConfigs.preprofile_time.Read());
+            profile_sm.Next();
+            break;
+        case SM_FAILED:
+            return true;
+        default:
+            break;
         }
         break;
 
     case ST_PREPROFILE_WAIT:
         if (CheckAction(ACTION_END_PREPROFILE)) {
-            profile_state = ST_REEL_OUT;
-            resend_attempted = false;
+            profile_sm.Next();
         }
         break;
 
-    case ST_REEL_OUT:
-        log_debug("FLA reel out");
-        mcb_motion = MOTION_REEL_OUT;
-        profile_state = ST_START_MOTION;
-        resend_attempted = false;
-        break;
-
-    case ST_REEL_IN:
-        log_debug("FLA reel in");
-        mcb_motion = MOTION_REEL_IN;
-        profile_state = ST_START_MOTION;
-        resend_attempted = false;
+    case ST_LEG:
+        // the next motion in the plan, every leg but the last stays well clear of the dock
+        log_debug("FLA profile leg");
+        mcb_motion = profile_legs[leg_index].motion;
+        if (MOTION_REEL_OUT == mcb_motion || MOTION_YOYO_OUT == mcb_motion) {
+            deploy_length = profile_legs[leg_index].length;
+        } else {
+            retract_length = profile_legs[leg_index].length;
+        }
+        profile_sm.Next();
         break;
 
     case ST_DOCK_WAIT:
         // wait for the timeout set for the reel out or the backup action, whichever comes first
         if (CheckAction(ACTION_MOTION_TIMEOUT) || CheckAction(ACTION_END_DOCK_WAIT)) {
-            profile_state = ST_DOCK;
+            CancelTimer(ACTION_END_DOCK_WAIT);
+            profile_sm.Next();
         }
         break;
 
     case ST_DOCK:
         log_debug("FLA dock");
         mcb_motion = MOTION_DOCK;
-        profile_state = ST_START_MOTION;
-        resend_attempted = false;
+        profile_sm.Next();
         break;
 
     case ST_GET_PU_STATUS:
-        if (Flight_CheckPU(false)) {
-            profile_state = ST_VERIFY_DOCK;
+        if (profile_sm.Entered()) {
+            Flight_CheckPU(true);
+        } else if (Flight_CheckPU(false)) {
+            profile_sm.Next();
         }
         break;
 
     case ST_VERIFY_DOCK:
         if (pibConfigs.pu_docked.Read()) {
-            mcbComm.TX_ASCII(MCB_ZERO_REEL);
-            delay(100);
-            mcbComm.TX_ASCII(MCB_GO_LOW_POWER);
-            scheduler.AddAction(RESEND_MCB_LP, MCB_RESEND_TIMEOUT);
-            profile_state = ST_CONFIRM_MCB_LP;
+            profile_sm.Next();
         } else {
             if ((pibConfigs.num_redock.Read() + 1) == ++redock_count) {
                 ZephyrLogCrit("No dock! Exceeded allowable number of redock attempts");
@@ -197,52 +229,32 @@ bool StratoPIB::Flight_Profile(bool restart_state)
             } else {
                 deploy_length = pibConfigs.redock_out.Read();
                 retract_length = pibConfigs.redock_in.Read();
-                Flight_ReDock(true);
-                profile_state = ST_REDOCK;
+                profile_sm.Transition(ST_REDOCK);
             }
         }
         break;
 
     case ST_REDOCK:
-        if (Flight_ReDock(false)) {
-            Flight_CheckPU(true);
-            profile_state = ST_GET_PU_STATUS;
+        if (profile_sm.Entered()) {
+            Flight_ReDock(true);
+        } else if (Flight_ReDock(false)) {
+            profile_sm.Next();
         }
         break;
 
     case ST_START_MOTION:
         log_debug("FLA start motion");
-        if (mcb_motion_ongoing) {
-            ZephyrLogWarn("Motion commanded while motion ongoing");
-            inst_substate = MODE_ERROR; // will force exit of Flight_Profile
-        }
-
-        if (StartMCBMotion()) {
-            profile_state = ST_VERIFY_MOTION;
-            scheduler.AddAction(RESEND_MOTION_COMMAND, MCB_RESEND_TIMEOUT);
-        } else {
-            ZephyrLogWarn("Motion start error");
+        // the dock comes after the last leg, so it uses the configured velocity
+        switch (AwaitMotionStart(profile_sm, (leg_index < num_legs) ? profile_legs[leg_index].velocity : 0.0f)) {
+        case SM_DONE:
+            ScheduleTimer(ACTION_MOTION_TIMEOUT, max_profile_seconds);
+            profile_sm.Next();
+            break;
+        case SM_FAILED:
             inst_substate = MODE_ERROR; // will force exit of Flight_Profile
-        }
-        break;
-
-    case ST_VERIFY_MOTION:
-        log_debug("FLA verify motion");
-        if (mcb_motion_ongoing) { // set in the Ack handler
-            log_nominal("MCB commanded motion");
-            scheduler.AddAction(ACTION_MOTION_TIMEOUT, max_profile_seconds);
-            profile_state = ST_MONITOR_MOTION;
-        }
-
-        if (CheckAction(RESEND_MOTION_COMMAND)) {
-            if (!resend_attempted) {
-                resend_attempted = true;
-                profile_state = ST_START_MOTION;
-            } else {
-                resend_attempted = false;
-                ZephyrLogWarn("MCB never confirmed motion");
-                inst_substate = MODE_ERROR; // will force exit of Flight_Profile
-            }
+            break;
+        default:
+            break;
         }
         break;
 
@@ -262,36 +274,49 @@ bool StratoPIB::Flight_Profile(bool restart_state)
             break;
         }
 
+        if (HandleMotionStall()) break;
+
         if (!mcb_motion_ongoing) {
             log_nominal("Motion complete");
-            switch (mcb_motion) {
-            case MOTION_REEL_OUT:
-                SendMCBTM(FINE, "Finished profile reel out");
-                if (scheduler.AddAction(ACTION_END_DWELL, pibConfigs.dwell_time.Read())) {
-                    snprintf(log_array, LOG_ARRAY_SIZE, "Scheduled dwell: %u s", pibConfigs.dwell_time.Read());
-                    log_nominal(log_array);
-                    profile_state = ST_DWELL;
-                } else {
-                    ZephyrLogCrit("Unable to schedule dwell");
-                    inst_substate = MODE_ERROR; // will force exit of Flight_Profile
-                }
-                break;
-            case MOTION_REEL_IN:
-                SendMCBTM(FINE, "Finished profile reel in");
-                scheduler.AddAction(ACTION_END_DOCK_WAIT, 60);
-                profile_state = ST_DOCK_WAIT;
-                break;
-            case MOTION_DOCK:
+            if (MOTION_DOCK == mcb_motion) {
                 // MCB TM sent in MCBRouter handler for MCB_MOTION_FAULT
                 redock_count = 0;
-                Flight_CheckPU(true); // start checking the PU
-                profile_state = ST_GET_PU_STATUS;
+                profile_sm.Transition(ST_GET_PU_STATUS);
                 break;
-            default:
+            }
+
+            if (leg_index >= num_legs || mcb_motion != profile_legs[leg_index].motion) {
                 SendMCBTM(CRIT, "Unknown motion finished in profile monitor");
                 inst_substate = MODE_ERROR; // will force exit of Flight_Profile
                 break;
             }
+
+            snprintf(log_array, LOG_ARRAY_SIZE, "Finished profile %s (leg %u/%u)", LegName(mcb_motion), leg_index + 1, num_legs);
+            SendMCBTM(FINE, log_array);
+            dwell = profile_legs[leg_index++].dwell;
+
+            if (0 != dwell) {
+                if (ScheduleTimer(ACTION_END_DWELL, dwell)) {
+                    snprintf(log_array, LOG_ARRAY_SIZE, "Scheduled dwell: %u s", dwell);
+                    log_nominal(log_array);
+                    profile_sm.Transition(ST_DWELL);
+                } else {
+                    ZephyrLogCrit("Unable to schedule dwell");
+                    inst_substate = MODE_ERROR; // will force exit of Flight_Profile
+                }
+            } else if (leg_index < num_legs) {
+                // straight into the next cast without stopping at the dock
+                profile_sm.Transition(ST_LEG);
+            } else if (ReelInDockWindow()) {
+                // the reel is where the dock expects it, no need to wait
+                snprintf(log_array, LOG_ARRAY_SIZE, "Reel at %0.1f revs, docking", reel_position);
+                log_nominal(log_array);
+                profile_sm.Transition(ST_DOCK);
+            } else {
+                // fall back to waiting for the reel to settle
+                ScheduleTimer(ACTION_END_DOCK_WAIT, 60);
+                profile_sm.Transition(ST_DOCK_WAIT);
+            }
         }
         break;
 
@@ -299,12 +324,23 @@ bool StratoPIB::Flight_Profile(bool restart_state)
         log_debug("FLA dwell");
         if (CheckAction(ACTION_END_DWELL)) {
             log_nominal("Finished dwell");
-            profile_state = ST_REEL_IN;
+            profile_sm.Next();
         }
         break;
 
     case ST_CONFIRM_MCB_LP:
-        if (mcb_low_power) {
+        if (profile_sm.Entered()) {
+            // only zero the reel on the first attempt, a retry just repeats the low power command
+            if (0 == profile_sm.Attempts()) {
+                mcbComm.TX_ASCII(MCB_ZERO_REEL);
+                delay(100);
+            }
+            mcbComm.TX_ASCII(MCB_GO_LOW_POWER);
+            ArmResend(profile_sm);
+        }
+
+        switch (AwaitAck(profile_sm, mcb_low_power)) {
+        case SM_DONE:
             log_nominal("Profile finished, MCB in low power");
             mcb_low_power = false;
             if(pibConfigs.pu_auto_offload.Read())
@@ -314,18 +350,13 @@ bool StratoPIB::Flight_Profile(bool restart_state)
                 SetAction(ACTION_OVERRIDE_TSEN);
             }
             return true;
-        } else if (CheckAction(RESEND_MCB_LP)) {
-            if (!resend_attempted) {
-                resend_attempted = true;
-                mcbComm.TX_ASCII(MCB_GO_LOW_POWER);
-            } else {
-                resend_attempted = false;
-                ZephyrLogWarn("MCB never powered off after profile");
-                inst_substate = MODE_ERROR; // will force exit of Flight_Profile
-            }
+        case SM_FAILED:
+            inst_substate = MODE_ERROR; // will force exit of Flight_Profile
+            break;
+        default:
+            break;
         }
         break;
-    
 
     default:
         // unknown state, exit
@@ -333,4 +364,4 @@ bool StratoPIB::Flight_Profile(bool restart_state)
     }
 
     return false; // assume incomplete
-}
\ No newline at end of file
+}
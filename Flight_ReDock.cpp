@@ -6,117 +6,94 @@
 
 #include "StratoPIB.h"
 
-enum ReDockStates_t {
+enum ReDockStates_t : uint8_t {
     ST_ENTRY,
     ST_IDLE,
     ST_START_MOTION,
-    ST_VERIFY_MOTION,
     ST_MONITOR_MOTION,
-    ST_CHECK_PU,
     ST_WAIT_PU,
+    NUM_REDOCK_STATES
 };
 
-static ReDockStates_t redock_state = ST_ENTRY;
-static bool resend_attempted = false;
+static const SMState_t redock_states[NUM_REDOCK_STATES] = {
+    // next             resend action          failure message
+    {ST_IDLE,           NO_ACTION,             NULL},  // ST_ENTRY
+    {ST_IDLE,           NO_ACTION,             NULL},  // ST_IDLE
+    {ST_MONITOR_MOTION, RESEND_MOTION_COMMAND, "MCB never confirmed motion"},  // ST_START_MOTION
+    {ST_IDLE,           NO_ACTION,             NULL},  // ST_MONITOR_MOTION
+    {ST_IDLE,           RESEND_PU_CHECK,       "PU not responding to status request"},  // ST_WAIT_PU
+};
+
+static PIBStateMachine<NUM_REDOCK_STATES> redock_sm(redock_states);
 
 bool StratoPIB::Flight_ReDock(bool restart_state)
 {
-    if (restart_state) redock_state = ST_ENTRY;
+    if (restart_state) redock_sm.Start(ST_ENTRY);
 
-    switch (redock_state) {
+    switch (redock_sm.State()) {
     case ST_ENTRY:
-        redock_state = ST_IDLE;
         SetAction(ACTION_REEL_OUT);
-        scheduler.AddAction(ACTION_IN_NO_LW, 30);
-        scheduler.AddAction(ACTION_CHECK_PU, 60);
+        ScheduleTimer(ACTION_IN_NO_LW, 30);
+        ScheduleTimer(ACTION_CHECK_PU, 60);
+        redock_sm.Next();
         break;
 
     case ST_IDLE:
         if (CheckAction(ACTION_REEL_OUT)) {
-            redock_state = ST_START_MOTION;
             mcb_motion = MOTION_REEL_OUT;
-            resend_attempted = false;
+            redock_sm.Transition(ST_START_MOTION);
         } else if (CheckAction(ACTION_IN_NO_LW)) {
-            redock_state = ST_START_MOTION;
             mcb_motion = MOTION_IN_NO_LW;
-            resend_attempted = false;
+            redock_sm.Transition(ST_START_MOTION);
         } else if (CheckAction(ACTION_CHECK_PU)) {
-            redock_state = ST_CHECK_PU;
-            resend_attempted = false;
+            redock_sm.Transition(ST_WAIT_PU);
         }
         break;
 
     case ST_START_MOTION:
-        if (mcb_motion_ongoing) {
-            ZephyrLogWarn("Motion commanded while motion ongoing");
-            inst_substate = MODE_ERROR; // will force exit of Flight_Profile
-        }
-
-        if (StartMCBMotion()) {
-            redock_state = ST_VERIFY_MOTION;
-            scheduler.AddAction(RESEND_MOTION_COMMAND, MCB_RESEND_TIMEOUT);
-        } else {
-            ZephyrLogWarn("Motion start error");
+        switch (AwaitMotionStart(redock_sm)) {
+        case SM_DONE:
+            redock_sm.Next();
+            break;
+        case SM_FAILED:
             inst_substate = MODE_ERROR; // will force exit of Flight_Profile
-        }
-        break;
-
-    case ST_VERIFY_MOTION:
-        if (mcb_motion_ongoing) { // set in the Ack handler
-            log_nominal("MCB commanded motion");
-            redock_state = ST_MONITOR_MOTION;
-        }
-
-        if (CheckAction(RESEND_MOTION_COMMAND)) {
-            if (!resend_attempted) {
-                resend_attempted = true;
-                redock_state = ST_START_MOTION;
-            } else {
-                resend_attempted = false;
-                ZephyrLogWarn("MCB never confirmed motion");
-                inst_substate = MODE_ERROR; // will force exit of Flight_Profile
-            }
+            break;
+        default:
+            break;
         }
         break;
 
     case ST_MONITOR_MOTION:
         if (CheckAction(ACTION_MOTION_STOP)) {
             // todo: verification of motion stop
+            CancelTimer(ACTION_IN_NO_LW);
+            CancelTimer(ACTION_CHECK_PU);
             ZephyrLogFine("Commanded motion stop");
             return true;
             break;
         }
 
         if (!mcb_motion_ongoing) {
-            redock_state = ST_IDLE;
+            redock_sm.Next();
         }
         break;
 
-    case ST_CHECK_PU:
-        puComm.TX_ASCII(PU_SEND_STATUS);
-        scheduler.AddAction(RESEND_PU_CHECK, PU_RESEND_TIMEOUT);
-        redock_state = ST_WAIT_PU;
-        break;
-
     case ST_WAIT_PU:
-        if (pibConfigs.pu_docked.Read()) {
-            snprintf(log_array, LOG_ARRAY_SIZE, "PU status: %lu, %0.2f, %0.2f, %0.2f, %0.2f, %u", pu_status.time, pu_status.v_battery, pu_status.i_charge, pu_status.therm1, pu_status.therm2, pu_status.heater_stat);
-            ZephyrLogFine(log_array);
+        if (redock_sm.Entered()) {
+            puComm.TX_ASCII(PU_SEND_STATUS);
+            ArmResend(redock_sm);
+        }
+
+        switch (AwaitAck(redock_sm, pibConfigs.pu_docked.Read())) {
+        case SM_DONE:
+            SendPUStatusTM();
             mcbComm.TX_ASCII(MCB_ZERO_REEL);
             return true;
+        case SM_FAILED:
+            return true;
+        default:
             break;
         }
-
-        if (CheckAction(RESEND_PU_CHECK)) {
-            if (!resend_attempted) {
-                resend_attempted = true;
-                redock_state = ST_CHECK_PU;
-            } else {
-                resend_attempted = false;
-                ZephyrLogWarn("PU not responding to status request");
-                return true;
-            }
-        }
         break;
 
     default:
@@ -125,4 +102,4 @@ bool StratoPIB::Flight_ReDock(bool restart_state)
     }
 
     return false; // assume incomplete
-}
\ No newline at end of file
+}
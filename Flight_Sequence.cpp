@@ -0,0 +1,239 @@
+/*
+ *  Flight_Sequence.cpp
+ *  Author:  Alex St. Clair
+ *  Created: October 2026
+ *
+ *  This file implements the interpreter for uploaded flight sequences
+ *  (see PIBSequence.h for the instruction set)
+ */
+
+#include "StratoPIB.h"
+
+enum SequenceStates_t : uint8_t {
+    ST_SEQ_RUN,
+    ST_SEQ_SUB,
+    ST_SEQ_WAIT,
+    ST_SEQ_WARMUP,
+    NUM_SEQUENCE_STATES
+};
+
+static const SMState_t sequence_states[NUM_SEQUENCE_STATES] = {
+    // next             resend action          failure message
+    {ST_SEQ_RUN,        NO_ACTION,             NULL},  // ST_SEQ_RUN
+    {ST_SEQ_RUN,        NO_ACTION,             NULL},  // ST_SEQ_SUB
+    {ST_SEQ_RUN,        NO_ACTION,             NULL},  // ST_SEQ_WAIT
+    {ST_SEQ_RUN,        RESEND_PU_WARMUP,      "PU not responding to warmup command"},  // ST_SEQ_WARMUP
+};
+
+// the ground-facing work requests, the rest drive resends, timeouts, and state changes inside the sequences
+const uint8_t StratoPIB::sequence_actions[] = {
+    ACTION_CHECK_PU,
+    ACTION_OFFLOAD_PU,
+    ACTION_SEND_HK,
+    COMMAND_REDOCK,
+    COMMAND_SEND_TSEN,
+    COMMAND_MANUAL_PROFILE,
+    COMMAND_DOCKED_PROFILE,
+};
+
+const uint8_t StratoPIB::num_sequence_actions = sizeof(sequence_actions) / sizeof(sequence_actions[0]);
+
+static PIBStateMachine<NUM_SEQUENCE_STATES> sequence_sm(sequence_states);
+static Sequence_t program;
+static uint8_t pc = 0;
+static uint8_t count = 0;
+static bool condition = false;
+static uint8_t wait_action = NO_ACTION;
+static bool (StratoPIB::*sub_sequence)(bool) = NULL;
+
+bool StratoPIB::Flight_Sequence(bool restart_state)
+{
+    if (restart_state) {
+        program = pibConfigs.sequence.Read();
+        pc = 0;
+        count = 0;
+        condition = false;
+        sequence_sm.Start(ST_SEQ_RUN);
+
+        // checked on upload, but guard against a corrupted EEPROM
+        if (!ValidateSequence(program, sequence_actions, num_sequence_actions)) {
+            ZephyrLogWarn("Stored sequence invalid");
+            program.length = 0;
+        }
+    }
+
+    switch (sequence_sm.State()) {
+    case ST_SEQ_RUN:
+        return RunSequence();
+
+    case ST_SEQ_SUB:
+        if (sequence_sm.Entered()) {
+            (this->*sub_sequence)(true);
+        } else if ((this->*sub_sequence)(false)) {
+            sequence_sm.Next();
+        }
+        break;
+
+    case ST_SEQ_WAIT:
+        if (NO_ACTION != wait_action && CheckAction(wait_action)) {
+            CancelTimer(ACTION_SEQUENCE_WAIT);
+            condition = true;
+            sequence_sm.Next();
+        } else if (CheckAction(ACTION_SEQUENCE_WAIT)) {
+            condition = false;
+            sequence_sm.Next();
+        }
+        break;
+
+    case ST_SEQ_WARMUP:
+        switch (AwaitPUWarmup(sequence_sm)) {
+        case SM_DONE:
+            sequence_sm.Next();
+            break;
+        case SM_FAILED:
+            return true;
+        default:
+            break;
+        }
+        break;
+
+    default:
+        // unknown state, exit
+        return true;
+    }
+
+    return false; // assume incomplete
+}
+
+// execute instructions until one blocks or the budget runs out, true when the sequence is finished
+bool StratoPIB::RunSequence()
+{
+    for (uint8_t i = 0; i < SEQUENCE_BUDGET; i++) {
+        if (pc >= program.length) {
+            ZephyrLogFine("Sequence complete");
+            return true;
+        }
+
+        uint8_t start = pc;
+        uint8_t op = program.code[pc];
+        const uint8_t * operands = &program.code[pc + 1];
+        uint16_t seconds = 0;
+        float length = 0.0f;
+
+        pc += 1 + SequenceOperandBytes(op);
+
+        switch (op) {
+        case SEQ_END:
+            ZephyrLogFine("Sequence complete");
+            return true;
+
+        case SEQ_MOTION:
+            memcpy(&length, &operands[1], sizeof(length));
+            mcb_motion = (MCBMotion_t) operands[0];
+            switch (mcb_motion) {
+            case MOTION_REEL_OUT:
+                deploy_length = length;
+                break;
+            case MOTION_REEL_IN:
+            case MOTION_IN_NO_LW:
+                retract_length = length;
+                break;
+            case MOTION_DOCK:
+                dock_length = length;
+                break;
+            default:
+                mcb_motion = NO_MOTION;
+                snprintf(log_array, LOG_ARRAY_SIZE, "Sequence: invalid motion at %u", start);
+                ZephyrLogWarn(log_array);
+                return true;
+            }
+            sub_sequence = &StratoPIB::Flight_ManualMotion;
+            sequence_sm.Transition(ST_SEQ_SUB);
+            return false;
+
+        case SEQ_CHECK_PU:
+            sub_sequence = &StratoPIB::Flight_CheckPU;
+            sequence_sm.Transition(ST_SEQ_SUB);
+            return false;
+
+        case SEQ_TSEN:
+            sub_sequence = &StratoPIB::Flight_TSEN;
+            sequence_sm.Transition(ST_SEQ_SUB);
+            return false;
+
+        case SEQ_OFFLOAD:
+            sub_sequence = &StratoPIB::Flight_PUOffload;
+            sequence_sm.Transition(ST_SEQ_SUB);
+            return false;
+
+        case SEQ_REDOCK:
+            // the same lengths as the automatic redock, not whatever the last motion left
+            deploy_length = pibConfigs.redock_out.Read();
+            retract_length = pibConfigs.redock_in.Read();
+            mcb_motion = MOTION_IN_NO_LW;
+            sub_sequence = &StratoPIB::Flight_ReDock;
+            sequence_sm.Transition(ST_SEQ_SUB);
+            return false;
+
+        case SEQ_PROFILE:
+            sub_sequence = &StratoPIB::Flight_Profile;
+            sequence_sm.Transition(ST_SEQ_SUB);
+            return false;
+
+        case SEQ_DOCKED_PROFILE:
+            sub_sequence = &StratoPIB::Flight_DockedProfile;
+            sequence_sm.Transition(ST_SEQ_SUB);
+            return false;
+
+        case SEQ_PU_WARMUP:
+            sequence_sm.Transition(ST_SEQ_WARMUP);
+            return false;
+
+        case SEQ_WAIT:
+            memcpy(&seconds, &operands[0], sizeof(seconds));
+            wait_action = NO_ACTION;
+            ScheduleTimer(ACTION_SEQUENCE_WAIT, seconds);
+            sequence_sm.Transition(ST_SEQ_WAIT);
+            return false;
+
+        case SEQ_WAIT_ACTION:
+            memcpy(&seconds, &operands[1], sizeof(seconds));
+            wait_action = operands[0];
+            ScheduleTimer(ACTION_SEQUENCE_WAIT, seconds);
+            sequence_sm.Transition(ST_SEQ_WAIT);
+            return false;
+
+        case SEQ_SET_ACTION:
+            SetAction(operands[0]);
+            break;
+
+        case SEQ_TM:
+            snprintf(log_array, LOG_ARRAY_SIZE, "Sequence marker %u", operands[0]);
+            ZephyrLogFine(log_array);
+            break;
+
+        case SEQ_SET_COUNT:
+            count = operands[0];
+            break;
+
+        case SEQ_LOOP:
+            if (0 != count && 0 != --count) pc = operands[0];
+            break;
+
+        case SEQ_JUMP:
+            pc = operands[0];
+            break;
+
+        case SEQ_JUMP_IF:
+            if (condition) pc = operands[0];
+            break;
+
+        default:
+            snprintf(log_array, LOG_ARRAY_SIZE, "Sequence: invalid opcode %u", op);
+            ZephyrLogWarn(log_array);
+            return true;
+        }
+    }
+
+    return false; // out of budget, continue next loop
+}
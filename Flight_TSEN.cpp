@@ -6,16 +6,23 @@
 
 #include "StratoPIB.h"
 
-enum TSENStates_t {
+enum TSENStates_t : uint8_t {
     ST_ENTRY,
     ST_GET_PU_STATUS,
-    ST_REQUEST_TSEN,
     ST_WAIT_TSEN,
     ST_TM_ACK,
+    NUM_TSEN_STATES
 };
 
-static TSENStates_t tsen_state = ST_ENTRY;
-static bool resend_attempted = false;
+static const SMState_t tsen_states[NUM_TSEN_STATES] = {
+    // next            resend action    failure message
+    {ST_GET_PU_STATUS, NO_ACTION,       NULL},  // ST_ENTRY
+    {ST_WAIT_TSEN,     NO_ACTION,       NULL},  // ST_GET_PU_STATUS
+    {ST_TM_ACK,        RESEND_PU_TSEN,  "PU not successful in sending TSEN"},  // ST_WAIT_TSEN
+    {ST_WAIT_TSEN,     RESEND_TM,       NULL},  // ST_TM_ACK
+};
+
+static PIBStateMachine<NUM_TSEN_STATES> tsen_sm(tsen_states);
 
 bool StratoPIB::Flight_TSEN(bool restart_state)
 {
@@ -27,64 +34,66 @@ bool StratoPIB::Flight_TSEN(bool restart_state)
         return true;
     }
 
-    if (restart_state) tsen_state = ST_ENTRY;
+    if (restart_state) tsen_sm.Start(ST_ENTRY);
 
-    switch (tsen_state) {
+    switch (tsen_sm.State()) {
     case ST_ENTRY:
-        resend_attempted = false;
+        tsen_records = 0;
         Flight_CheckPU(true);
-        tsen_state = ST_GET_PU_STATUS;
+        tsen_sm.Next();
         break;
 
     case ST_GET_PU_STATUS:
         if (Flight_CheckPU(false)) {
-            tsen_state = ST_REQUEST_TSEN;
+            tsen_sm.Next();
         }
         break;
 
-    case ST_REQUEST_TSEN:
-        puComm.TX_ASCII(PU_SEND_TSEN_RECORD);
-        scheduler.AddAction(RESEND_PU_TSEN, PU_RESEND_TIMEOUT);
-        tsen_received = false;
-        pu_no_more_records = false;
-        tsen_state = ST_WAIT_TSEN;
-        break;
-
     case ST_WAIT_TSEN:
-        if (tsen_received) { // ACK/NAK in PURouter
+        if (tsen_sm.Entered()) {
             tsen_received = false;
-            snprintf(log_array, LOG_ARRAY_SIZE, "Received TSEN: %u", puComm.binary_rx.bin_length);
-            log_nominal(log_array);
-            SendTSENTM();
-            tsen_state = ST_TM_ACK;
-            scheduler.AddAction(RESEND_TM, ZEPHYR_RESEND_TIMEOUT);
-            break;
-        } else if (pu_no_more_records) {
             pu_no_more_records = false;
+            puComm.TX_ASCII(PU_SEND_TSEN_RECORD);
+            ArmResend(tsen_sm);
+        }
+
+        if (pu_no_more_records) {
+            pu_no_more_records = false;
+            CancelTimer(RESEND_PU_TSEN);
             log_nominal("No more TSEN records");
+            AdaptTSENPeriod();
             return true;
         }
 
-        if (CheckAction(RESEND_PU_TSEN)) {
-            if (!resend_attempted) {
-                resend_attempted = true;
-                tsen_state = ST_REQUEST_TSEN;
-            } else {
-                resend_attempted = false;
-                ZephyrLogWarn("PU not successful in sending TSEN");
-                return true;
-            }
+        switch (AwaitAck(tsen_sm, tsen_received)) { // ACK/NAK in PURouter
+        case SM_DONE:
+            tsen_received = false;
+            if (tsen_records < UINT8_MAX) tsen_records++;
+            snprintf(log_array, LOG_ARRAY_SIZE, "Received TSEN: %u", puComm.binary_rx.bin_length);
+            log_nominal(log_array);
+            SendTSENTM();
+            tsen_sm.Next();
+            break;
+        case SM_FAILED:
+            AdaptTSENPeriod(); // adapt to the records drained before the PU stopped responding
+            return true;
+        default:
+            break;
         }
         break;
 
     case ST_TM_ACK:
-        if (ACK == TM_ack_flag) {
-            tsen_state = ST_ENTRY;
-        } else if (NAK == TM_ack_flag || CheckAction(RESEND_TM)) {
-            // attempt one resend
-            log_error("Needed to resend TM");
-            zephyrTX.TM(); // message is still saved in XMLWriter, no need to reconstruct
-            tsen_state = ST_ENTRY;
+        // the PU status is fresh for this poll, so drain the backlog without re-checking it
+        switch (AwaitTMAck(tsen_sm)) {
+        case SM_DONE:
+            tsen_sm.Next();
+            break;
+        case SM_FAILED:
+            // stop draining over a failing TM link, but still adapt to the records drained so far
+            AdaptTSENPeriod();
+            return true;
+        default:
+            break;
         }
         break;
 
@@ -94,4 +103,4 @@ bool StratoPIB::Flight_TSEN(bool restart_state)
     }
 
     return false; // assume incomplete
-}
\ No newline at end of file
+}
@@ -0,0 +1,203 @@
+/*
+ *  Housekeeping.cpp
+ *  Author:  Alex St. Clair
+ *  Created: October 2026
+ *
+ *  This file implements the periodic PIB housekeeping TM, a compact
+ *  binary record of the PIB's link statistics (see PIBLinkStats.h). All
+ *  fields are big-endian and follow a version byte and the UNIX time:
+ *
+ *    per resend action (NUM_RESEND_CLASSES): srtt_ms (u16), rttvar_ms (u16),
+ *      max_ms (u16), samples (u16), timeouts (u16), retries (u16),
+ *      failures (u16), fail_fast (u16)
+ *    per peer (Zephyr, MCB, PU): remaining error budget (u8)
+ *    per link (Zephyr, MCB, PU, LoRa): rx_msgs (u32), rx_bytes (u32),
+ *      tx_bytes (u32), checksum_errors (u16), naks (u16), unknown_ids (u16),
+ *      resends (u16)
+ *    per Zephyr TX category (MCB TM, TSEN, profile, LoRa TM, EEPROM,
+ *      housekeeping, RA, safety, other): tx_bytes (u32)
+ *    LoRa link: snr (i16, 0.1 dB), rssi (i16, dBm), packets (u16),
+ *      recommended SF (u8), radio SF (u8)
+ *
+ *  Millisecond and u16 counter fields saturate at 65535. The Zephyr
+ *  rx_msgs counts TCs, and its checksum_errors stays 0, since the XML
+ *  framing and CRCs are checked in StratoCore. LoRa is receive only.
+ *
+ *  It also implements the route statistics TM, sent on request, with the
+ *  same header and encoding:
+ *
+ *    per router (MCB, PU): num_routes (u8), then per route: type (u8),
+ *      id (u8), count (u32), total_us (u32), max_us (u32)
+ */
+
+#include "StratoPIB.h"
+
+#define HK_VERSION      4
+#define HK_BUFFER_SIZE  384
+
+#define ROUTE_STATS_VERSION     1
+#define ROUTE_STATS_SIZE        512
+#define ROUTE_STATS_ENTRY       14
+
+static uint16_t Saturate16(uint32_t value)
+{
+    return (value > UINT16_MAX) ? UINT16_MAX : (uint16_t) value;
+}
+
+static void Push16(uint8_t * buffer, uint16_t & index, uint16_t value)
+{
+    buffer[index++] = (uint8_t) (value >> 8);
+    buffer[index++] = (uint8_t) value;
+}
+
+static void Push32(uint8_t * buffer, uint16_t & index, uint32_t value)
+{
+    Push16(buffer, index, (uint16_t) (value >> 16));
+    Push16(buffer, index, (uint16_t) value);
+}
+
+void StratoPIB::SendZephyrTM(uint8_t category)
+{
+    uint32_t tx_start = zephyr_link.TXBytes();
+
+    zephyrTX.TM();
+
+    last_tm_category = category; // a resend is counted under the same category
+    CountZephyrTX(category, tx_start);
+}
+
+void StratoPIB::CountZephyrTX(uint8_t category, uint32_t tx_start)
+{
+    if (category >= NUM_ZEPHYR_CATEGORIES) return;
+
+    zephyr_tx_bytes[category] += zephyr_link.TXBytes() - tx_start;
+}
+
+void StratoPIB::CountResend(uint8_t resend_action)
+{
+    uint8_t resend_class = ResendClass(resend_action);
+
+    if (RTT_NONE == resend_class) return;
+
+    link_stats[retry.Policy(resend_class).peer].resends++;
+}
+
+// every hk_period seconds (called in InstrumentLoop)
+void StratoPIB::CheckHousekeeping()
+{
+    static time_t last_hk = 0;
+
+    if (0 == pibConfigs.hk_period.Read()) return;
+
+    if (now() >= last_hk + pibConfigs.hk_period.Read()) {
+        last_hk = now();
+        SetAction(ACTION_SEND_HK);
+    }
+}
+
+void StratoPIB::SendHousekeepingTM()
+{
+    uint8_t buffer[HK_BUFFER_SIZE];
+    uint16_t index = 0;
+
+    buffer[index++] = HK_VERSION;
+    Push32(buffer, index, (uint32_t) now());
+
+    for (uint8_t i = 0; i < NUM_RESEND_CLASSES; i++) {
+        const RTTStats_t & rtt = latency.Stats(i);
+        const RetryStats_t & retries = retry.Stats(i);
+        Push16(buffer, index, Saturate16(rtt.srtt_ms));
+        Push16(buffer, index, Saturate16(rtt.rttvar_ms));
+        Push16(buffer, index, Saturate16(rtt.max_ms));
+        Push16(buffer, index, rtt.samples);
+        Push16(buffer, index, rtt.timeouts);
+        Push16(buffer, index, retries.retries);
+        Push16(buffer, index, retries.failures);
+        Push16(buffer, index, retries.fail_fast);
+    }
+
+    for (uint8_t i = 0; i < NUM_RETRY_PEERS; i++) {
+        buffer[index++] = retry.Budget(i);
+    }
+
+    for (uint8_t i = 0; i < NUM_LINKS; i++) {
+        const LinkStats_t & link = link_stats[i];
+        Push32(buffer, index, link.rx_msgs);
+        Push32(buffer, index, link.rx_bytes);
+        Push32(buffer, index, link.tx_bytes);
+        Push16(buffer, index, Saturate16(link.checksum_errors));
+        Push16(buffer, index, Saturate16(link.naks));
+        Push16(buffer, index, Saturate16(link.unknown_ids));
+        Push16(buffer, index, Saturate16(link.resends));
+    }
+
+    // whatever isn't categorized (logs, IMR, TC acks) is the remainder
+    uint32_t categorized = 0;
+    for (uint8_t i = 0; i < NUM_ZEPHYR_CATEGORIES; i++) {
+        Push32(buffer, index, zephyr_tx_bytes[i]);
+        categorized += zephyr_tx_bytes[i];
+    }
+    Push32(buffer, index, link_stats[LINK_ZEPHYR].tx_bytes - categorized);
+
+    Push16(buffer, index, (uint16_t) (int16_t) (lora_link.SNR() * 10.0f));
+    Push16(buffer, index, (uint16_t) (int16_t) lora_link.RSSI());
+    Push16(buffer, index, lora_link.Packets());
+    buffer[index++] = lora_link.Recommended();
+    buffer[index++] = pibConfigs.lora_sf.Read();
+
+    zephyrTX.clearTm();
+    zephyrTX.addTm(buffer, index);
+
+    zephyrTX.setStateDetails(1, "PIB housekeeping");
+    zephyrTX.setStateFlagValue(1, FINE);
+    zephyrTX.setStateFlagValue(2, NOMESS);
+    zephyrTX.setStateFlagValue(3, NOMESS);
+
+    TM_ack_flag = NO_ACK;
+    SendZephyrTM(ZCAT_HOUSEKEEPING);
+
+    log_nominal("Sent housekeeping TM");
+}
+
+static void PushRouteStats(uint8_t * buffer, uint16_t & index, const MessageRoute_t * routes,
+                           const RouteStats_t * stats, uint8_t num_routes)
+{
+    // leave room for the other router's count
+    uint8_t room = (ROUTE_STATS_SIZE - 1 - index - 1) / ROUTE_STATS_ENTRY;
+    if (num_routes > room) num_routes = room;
+
+    buffer[index++] = num_routes;
+
+    for (uint8_t i = 0; i < num_routes; i++) {
+        buffer[index++] = routes[i].type;
+        buffer[index++] = routes[i].id;
+        Push32(buffer, index, stats[i].count);
+        Push32(buffer, index, stats[i].total_us);
+        Push32(buffer, index, stats[i].max_us);
+    }
+}
+
+void StratoPIB::SendRouteStatsTM()
+{
+    uint8_t buffer[ROUTE_STATS_SIZE];
+    uint16_t index = 0;
+
+    buffer[index++] = ROUTE_STATS_VERSION;
+    Push32(buffer, index, (uint32_t) now());
+
+    PushRouteStats(buffer, index, mcb_routes, mcb_route_stats, num_mcb_routes);
+    PushRouteStats(buffer, index, pu_routes, pu_route_stats, num_pu_routes);
+
+    zephyrTX.clearTm();
+    zephyrTX.addTm(buffer, index);
+
+    zephyrTX.setStateDetails(1, "PIB route statistics");
+    zephyrTX.setStateFlagValue(1, FINE);
+    zephyrTX.setStateFlagValue(2, NOMESS);
+    zephyrTX.setStateFlagValue(3, NOMESS);
+
+    TM_ack_flag = NO_ACK;
+    SendZephyrTM(ZCAT_HOUSEKEEPING);
+
+    log_nominal("Sent route statistics TM");
+}
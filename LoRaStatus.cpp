@@ -0,0 +1,154 @@
+/*
+ *  LoRaStatus.cpp
+ *  Author:  Alex St. Clair
+ *  Created: October 2026
+ *
+ *  This file batches the PU's LoRa status broadcasts ("ST" packets). Each
+ *  is parsed into a fixed record with the packet's RSSI and SNR, and the
+ *  records are sent together in one TM every lora_status_period seconds,
+ *  or sooner if the ring fills. The TM is only sent from the idle
+ *  substates (as is housekeeping), so it never takes the TM buffer or ack
+ *  flag from a sequence waiting on its own TM. While a batch waits, a
+ *  full ring drops its oldest record. The TM payload is big-endian:
+ *
+ *    version (u8), num_records (u8), then per record: rx_time (u32),
+ *      rssi_dbm (i16), snr (i8, 0.25 dB), PU time (u32), v_battery (f32),
+ *      i_charge (f32), therm1 (f32), therm2 (f32), heater_stat (u8)
+ *
+ *  With a period of 0, or if a packet can't be parsed, the string is
+ *  forwarded with ZephyrLogFine as it was before.
+ */
+
+#include "StratoPIB.h"
+
+#define LORA_STATUS_VERSION     1
+#define LORA_STATUS_RECORD_SIZE 28
+
+static void Push32(uint8_t * buffer, uint16_t & index, uint32_t value)
+{
+    buffer[index++] = (uint8_t) (value >> 24);
+    buffer[index++] = (uint8_t) (value >> 16);
+    buffer[index++] = (uint8_t) (value >> 8);
+    buffer[index++] = (uint8_t) value;
+}
+
+static void PushFloat(uint8_t * buffer, uint16_t & index, float value)
+{
+    uint32_t bits = 0;
+    memcpy(&bits, &value, sizeof(bits));
+    Push32(buffer, index, bits);
+}
+
+// parse "ST" followed by time, v_battery, i_charge, therm1, therm2, heater_stat, comma separated
+static bool ParseLoRaStatus(const char * packet, LoRaStatus_t * record)
+{
+    const char * next = packet + 2;
+    char * end = NULL;
+    float values[4] = {0};
+
+    while (':' == *next || ',' == *next || ' ' == *next) next++;
+
+    record->pu_time = strtoul(next, &end, 10);
+    if (end == next) return false;
+
+    for (uint8_t i = 0; i < 4; i++) {
+        next = end;
+        if (',' != *next++) return false;
+        values[i] = strtof(next, &end);
+        if (end == next) return false;
+    }
+
+    next = end;
+    if (',' != *next++) return false;
+    record->heater_stat = (uint8_t) strtoul(next, &end, 10);
+    if (end == next) return false;
+
+    record->v_battery = values[0];
+    record->i_charge = values[1];
+    record->therm1 = values[2];
+    record->therm2 = values[3];
+
+    return true;
+}
+
+// called in LoRaRX with the null-terminated packet
+void StratoPIB::HandleLoRaStatus(const char * packet, int rssi, float snr)
+{
+    LoRaStatus_t record = {0};
+
+    if (0 == pibConfigs.lora_status_period.Read() || !ParseLoRaStatus(packet, &record)) {
+        ZephyrLogFine(packet);
+        return;
+    }
+
+    record.rx_time = now();
+    record.rssi = (int16_t) rssi;
+    float snr_quarters = snr * 4.0f;
+    if (snr_quarters > 127.0f) snr_quarters = 127.0f;
+    if (snr_quarters < -128.0f) snr_quarters = -128.0f;
+    record.snr = (int8_t) snr_quarters;
+
+    if (0 == lora_status_count) lora_status_first = now();
+
+    // the batch is waiting for an idle substate, keep the newest records
+    if (LORA_STATUS_RECORDS == lora_status_count) {
+        memmove(&lora_status[0], &lora_status[1], (LORA_STATUS_RECORDS - 1) * sizeof(LoRaStatus_t));
+        lora_status_count--;
+        lora_status_dropped++;
+    }
+
+    lora_status[lora_status_count++] = record;
+}
+
+// request the batch once the period has passed since its first record, or when the ring is full (called in InstrumentLoop)
+void StratoPIB::CheckLoRaStatus()
+{
+    if (0 == lora_status_count) return;
+
+    if (LORA_STATUS_RECORDS == lora_status_count ||
+        now() >= lora_status_first + pibConfigs.lora_status_period.Read()) {
+        SetAction(ACTION_SEND_LORA_STATUS); // coalesces while pending
+    }
+}
+
+// called from the idle substates on ACTION_SEND_LORA_STATUS
+void StratoPIB::SendLoRaStatusTM()
+{
+    uint8_t buffer[2 + LORA_STATUS_RECORDS * LORA_STATUS_RECORD_SIZE];
+    uint16_t index = 0;
+
+    if (0 == lora_status_count) return;
+
+    buffer[index++] = LORA_STATUS_VERSION;
+    buffer[index++] = lora_status_count;
+
+    for (uint8_t i = 0; i < lora_status_count; i++) {
+        const LoRaStatus_t & record = lora_status[i];
+        Push32(buffer, index, record.rx_time);
+        buffer[index++] = (uint8_t) ((uint16_t) record.rssi >> 8);
+        buffer[index++] = (uint8_t) record.rssi;
+        buffer[index++] = (uint8_t) record.snr;
+        Push32(buffer, index, record.pu_time);
+        PushFloat(buffer, index, record.v_battery);
+        PushFloat(buffer, index, record.i_charge);
+        PushFloat(buffer, index, record.therm1);
+        PushFloat(buffer, index, record.therm2);
+        buffer[index++] = record.heater_stat;
+    }
+
+    zephyrTX.clearTm();
+    zephyrTX.addTm(buffer, index);
+
+    snprintf(log_array, LOG_ARRAY_SIZE, "PU LoRa status x%u, %u dropped", lora_status_count, lora_status_dropped);
+    zephyrTX.setStateDetails(1, log_array);
+    zephyrTX.setStateFlagValue(1, FINE);
+    zephyrTX.setStateFlagValue(2, NOMESS);
+    zephyrTX.setStateFlagValue(3, NOMESS);
+
+    TM_ack_flag = NO_ACK;
+    SendZephyrTM(ZCAT_LORA_TM);
+
+    log_nominal(log_array);
+    lora_status_count = 0;
+    lora_status_dropped = 0;
+}
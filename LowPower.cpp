@@ -8,6 +8,9 @@
 
 #include "StratoPIB.h"
 
+// sends of the low power command, to back off its resends
+static uint8_t lp_attempts = 0;
+
 enum LPStates_t : uint8_t {
     LP_ENTRY = MODE_ENTRY,
 
@@ -27,17 +30,19 @@ void StratoPIB::LowPowerMode()
     case LP_ENTRY:
         // perform setup
         log_nominal("Entering LP");
+        lp_attempts = 0;
         inst_substate = LP_ALERT_MCB;
         break;
     case LP_ALERT_MCB:
         log_nominal("Commanding MCB low power");
         mcbComm.TX_ASCII(MCB_GO_LOW_POWER);
-        scheduler.AddAction(RESEND_MCB_LP, MCB_RESEND_TIMEOUT);
+        ScheduleResend(RESEND_MCB_LP, lp_attempts);
         inst_substate = LP_CHECK_MCB;
         break;
     case LP_CHECK_MCB:
         log_debug("Waiting on MCB LP ack");
         if (mcb_low_power) {
+            ResendAcked(RESEND_MCB_LP, lp_attempts);
             mcb_low_power = false;
             inst_substate = LP_LOOP;
         } else if (CheckAction(RESEND_MCB_LP)) {
@@ -9,164 +9,149 @@
 #include "StratoPIB.h"
 #include "Serialize.h"
 
+// one route per MCB message the PIB handles
+const MessageRoute_t StratoPIB::mcb_routes[] = {
+    // type         id                   handler                              log only
+    {ASCII_MESSAGE,  MCB_MOTION_FINISHED, &StratoPIB::HandleMCBMotionFinished, NULL},
+    {ASCII_MESSAGE,  MCB_MOTION_FAULT,    &StratoPIB::HandleMCBMotionFault,    NULL},
+    {ACK_MESSAGE,    MCB_GO_LOW_POWER,    &StratoPIB::HandleMCBLowPowerAck,    NULL},
+    {ACK_MESSAGE,    MCB_REEL_IN,         &StratoPIB::HandleMCBMotionAck,      NULL},
+    {ACK_MESSAGE,    MCB_REEL_OUT,        &StratoPIB::HandleMCBMotionAck,      NULL},
+    {ACK_MESSAGE,    MCB_DOCK,            &StratoPIB::HandleMCBMotionAck,      NULL},
+    {ACK_MESSAGE,    MCB_IN_NO_LW,        &StratoPIB::HandleMCBMotionAck,      NULL},
+    {ACK_MESSAGE,    MCB_FULL_RETRACT,    &StratoPIB::HandleMCBRetractAck,     NULL},
+    {ACK_MESSAGE,    MCB_IN_ACC,          NULL,                                "MCB acked retract acc"},
+    {ACK_MESSAGE,    MCB_OUT_ACC,         NULL,                                "MCB acked deploy acc"},
+    {ACK_MESSAGE,    MCB_DOCK_ACC,        NULL,                                "MCB acked dock acc"},
+    {ACK_MESSAGE,    MCB_ZERO_REEL,       NULL,                                "MCB acked zero reel"},
+    {ACK_MESSAGE,    MCB_TEMP_LIMITS,     NULL,                                "MCB acked temp limits"},
+    {ACK_MESSAGE,    MCB_TORQUE_LIMITS,   NULL,                                "MCB acked torque limits"},
+    {ACK_MESSAGE,    MCB_CURR_LIMITS,     NULL,                                "MCB acked curr limits"},
+    {ACK_MESSAGE,    MCB_IGNORE_LIMITS,   NULL,                                "MCB acked ignore limits"},
+    {ACK_MESSAGE,    MCB_USE_LIMITS,      NULL,                                "MCB acked use limits"},
+    {BIN_MESSAGE,    MCB_MOTION_TM,       &StratoPIB::HandleMCBMotionTM,       NULL},
+    {BIN_MESSAGE,    MCB_EEPROM,          &StratoPIB::SendMCBEEPROM,           NULL},
+    {STRING_MESSAGE, MCB_ERROR,           &StratoPIB::HandleMCBError,          NULL},
+};
+
+const uint8_t StratoPIB::num_mcb_routes = sizeof(mcb_routes) / sizeof(mcb_routes[0]);
+RouteStats_t StratoPIB::mcb_route_stats[sizeof(mcb_routes) / sizeof(mcb_routes[0])] = {{0}};
+
 void StratoPIB::RunMCBRouter()
 {
     SerialMessage_t rx_msg = mcbComm.RX();
 
     while (NO_MESSAGE != rx_msg) {
-        if (ASCII_MESSAGE == rx_msg) {
-            HandleMCBASCII();
-        } else if (ACK_MESSAGE == rx_msg) {
-            HandleMCBAck();
-        } else if (BIN_MESSAGE == rx_msg) {
-            HandleMCBBin();
-        } else if (STRING_MESSAGE == rx_msg) {
-            HandleMCBString();
-        } else {
-            log_error("Unknown message type from MCB");
-        }
-
+        DispatchMessage(mcbComm, rx_msg, LINK_MCB, mcb_routes, mcb_route_stats, num_mcb_routes);
         rx_msg = mcbComm.RX();
     }
 }
 
-void StratoPIB::HandleMCBASCII()
+void StratoPIB::HandleMCBMotionFinished()
 {
-    switch (mcbComm.ascii_rx.msg_id) {
-    case MCB_MOTION_FINISHED:
-        CheckAction(ACTION_MOTION_TIMEOUT); // clear the timeout
-        log_nominal("MCB motion finished"); // state machine will report to Zephyr
-        mcb_motion_ongoing = false;
-        break;
-    case MCB_MOTION_FAULT:
-        CheckAction(ACTION_MOTION_TIMEOUT); // clear the timeout
-        // if flag already cleared, assume this is the repeat
-        if (!mcb_motion_ongoing) return;
-
-        if (mcbComm.RX_Motion_Fault(motion_fault, motion_fault+1, motion_fault+2, motion_fault+3,
-                                    motion_fault+4, motion_fault+5, motion_fault+6, motion_fault+7)) {
-            // expected if docking
-            if (mcb_dock_ongoing) { // todo: ensure the correct motion fault flags for dock
-                snprintf(log_array, LOG_ARRAY_SIZE, "MCB: dock condition assumed: %x,%x,%x,%x,%x,%x,%x,%x", motion_fault[0], motion_fault[1],
-                         motion_fault[2], motion_fault[3], motion_fault[4], motion_fault[5], motion_fault[6], motion_fault[7]);
-                SendMCBTM(FINE, log_array);
-                mcb_dock_ongoing = false;
-                mcb_motion_ongoing = false;
-                return;
-            }
+    CancelTimer(ACTION_MOTION_TIMEOUT);
+    log_nominal("MCB motion finished"); // state machine will report to Zephyr
+    if (mcb_motion_ongoing) LearnMotionTime();
+    mcb_motion_ongoing = false;
+}
 
-            mcb_motion_ongoing = false;
-            snprintf(log_array, LOG_ARRAY_SIZE, "MCB Fault: %x,%x,%x,%x,%x,%x,%x,%x", motion_fault[0], motion_fault[1],
+void StratoPIB::HandleMCBMotionFault()
+{
+    CancelTimer(ACTION_MOTION_TIMEOUT);
+    // if flag already cleared, assume this is the repeat
+    if (!mcb_motion_ongoing) return;
+
+    if (mcbComm.RX_Motion_Fault(motion_fault, motion_fault+1, motion_fault+2, motion_fault+3,
+                                motion_fault+4, motion_fault+5, motion_fault+6, motion_fault+7)) {
+        // expected if docking
+        if (mcb_dock_ongoing) { // todo: ensure the correct motion fault flags for dock
+            snprintf(log_array, LOG_ARRAY_SIZE, "MCB: dock condition assumed: %x,%x,%x,%x,%x,%x,%x,%x", motion_fault[0], motion_fault[1],
                      motion_fault[2], motion_fault[3], motion_fault[4], motion_fault[5], motion_fault[6], motion_fault[7]);
-            SendMCBTM(CRIT, log_array);
-            inst_substate = MODE_ERROR;
-        } else {
-            if (mcb_dock_ongoing) {
-                SendMCBTM(FINE, "MCB dock detected: error receiving expected fault info");
-                mcb_dock_ongoing = false;
-                mcb_motion_ongoing = false;
-                return;
-            }
+            SendMCBTM(FINE, log_array);
+            mcb_dock_ongoing = false;
             mcb_motion_ongoing = false;
-            SendMCBTM(CRIT, "MCB Fault: error receiving parameters");
-            inst_substate = MODE_ERROR;
+            return;
         }
-        break;
-    default:
-        log_error("Unknown MCB ASCII message received");
-        break;
+
+        mcb_motion_ongoing = false;
+        snprintf(log_array, LOG_ARRAY_SIZE, "MCB Fault: %x,%x,%x,%x,%x,%x,%x,%x", motion_fault[0], motion_fault[1],
+                 motion_fault[2], motion_fault[3], motion_fault[4], motion_fault[5], motion_fault[6], motion_fault[7]);
+        SendMCBTM(CRIT, log_array);
+        inst_substate = MODE_ERROR;
+    } else {
+        if (mcb_dock_ongoing) {
+            SendMCBTM(FINE, "MCB dock detected: error receiving expected fault info");
+            mcb_dock_ongoing = false;
+            mcb_motion_ongoing = false;
+            return;
+        }
+        mcb_motion_ongoing = false;
+        SendMCBTM(CRIT, "MCB Fault: error receiving parameters");
+        inst_substate = MODE_ERROR;
     }
 }
 
-void StratoPIB::HandleMCBAck()
+void StratoPIB::HandleMCBLowPowerAck()
 {
+    log_nominal("MCB in low power");
+    latency.Received(ResendClass(RESEND_MCB_LP));
+    mcb_low_power = true;
+}
+
+// the motion has started if the ack matches the motion commanded
+void StratoPIB::HandleMCBMotionAck()
+{
+    bool matches = false;
+
     switch (mcbComm.ack_id) {
-    case MCB_GO_LOW_POWER:
-        log_nominal("MCB in low power");
-        mcb_low_power = true;
-        break;
     case MCB_REEL_IN:
-        if (MOTION_REEL_IN == mcb_motion) NoteProfileStart();
+        matches = (MOTION_REEL_IN == mcb_motion || MOTION_YOYO_IN == mcb_motion);
         break;
     case MCB_REEL_OUT:
-        if (MOTION_REEL_OUT == mcb_motion) NoteProfileStart();
+        matches = (MOTION_REEL_OUT == mcb_motion || MOTION_YOYO_OUT == mcb_motion);
         break;
     case MCB_DOCK:
-        if (MOTION_DOCK == mcb_motion) NoteProfileStart();
+        matches = (MOTION_DOCK == mcb_motion);
         break;
     case MCB_IN_NO_LW:
-        if (MOTION_IN_NO_LW == mcb_motion) NoteProfileStart();
-        break;
-    case MCB_FULL_RETRACT:
-        mcb_reeling_in = true;
-        break;
-    case MCB_IN_ACC:
-        ZephyrLogFine("MCB acked retract acc");
-        break;
-    case MCB_OUT_ACC:
-        ZephyrLogFine("MCB acked deploy acc");
-        break;
-    case MCB_DOCK_ACC:
-        ZephyrLogFine("MCB acked dock acc");
-        break;
-    case MCB_ZERO_REEL:
-        ZephyrLogFine("MCB acked zero reel");
-        break;
-    case MCB_TEMP_LIMITS:
-        ZephyrLogFine("MCB acked temp limits");
-        break;
-    case MCB_TORQUE_LIMITS:
-        ZephyrLogFine("MCB acked torque limits");
-        break;
-    case MCB_CURR_LIMITS:
-        ZephyrLogFine("MCB acked curr limits");
-        break;
-    case MCB_IGNORE_LIMITS:
-        ZephyrLogFine("MCB acked ignore limits");
-        break;
-    case MCB_USE_LIMITS:
-        ZephyrLogFine("MCB acked use limits");
+        matches = (MOTION_IN_NO_LW == mcb_motion);
         break;
     default:
-        log_error("Unknown MCB ack received");
         break;
     }
+
+    if (matches) {
+        latency.Received(ResendClass(RESEND_MOTION_COMMAND));
+        NoteProfileStart();
+    }
 }
 
-void StratoPIB::HandleMCBBin()
+void StratoPIB::HandleMCBRetractAck()
+{
+    latency.Received(ResendClass(RESEND_FULL_RETRACT));
+    mcb_reeling_in = true;
+}
+
+void StratoPIB::HandleMCBMotionTM()
 {
     float reel_pos = 0;
     uint16_t reel_pos_index = 21; // todo: don't hard-code this
 
-    switch (mcbComm.binary_rx.bin_id) {
-    case MCB_MOTION_TM:
-        if (BufferGetFloat(&reel_pos, mcbComm.binary_rx.bin_buffer, mcbComm.binary_rx.bin_length, &reel_pos_index)) {
-            snprintf(log_array, 101, "Reel position: %ld", (int32_t) reel_pos);
-            log_nominal(log_array);
-        } else {
-            log_nominal("Recieved MCB bin: unable to read position");
-        }
-        AddMCBTM();
-        break;
-    case MCB_EEPROM:
-        SendMCBEEPROM();
-        break;
-    default:
-        log_error("Unknown MCB bin received");
+    if (BufferGetFloat(&reel_pos, mcbComm.binary_rx.bin_buffer, mcbComm.binary_rx.bin_length, &reel_pos_index)) {
+        reel_position = reel_pos;
+        reel_position_time = millis();
+        trace.Log(TR_REEL_POSITION, (uint32_t) (int32_t) reel_pos);
+        MonitorMotion(reel_pos);
+    } else {
+        log_nominal("Recieved MCB bin: unable to read position");
     }
+    AddMCBTM();
 }
 
-void StratoPIB::HandleMCBString()
+void StratoPIB::HandleMCBError()
 {
-    switch (mcbComm.string_rx.str_id) {
-    case MCB_ERROR:
-        if (mcbComm.RX_Error(log_array, LOG_ARRAY_SIZE)) {
-            ZephyrLogCrit(log_array);
-            inst_substate = MODE_ERROR;
-        }
-        break;
-    default:
-        log_error("Unknown MCB String message received");
-        break;
+    if (mcbComm.RX_Error(log_array, LOG_ARRAY_SIZE)) {
+        ZephyrLogCrit(log_array);
+        inst_substate = MODE_ERROR;
     }
 }
@@ -0,0 +1,75 @@
+/*
+ *  MessageDispatch.cpp
+ *  Author:  Alex St. Clair
+ *  Created: October 2026
+ *
+ *  This file implements the table-driven dispatch shared by the MCB and
+ *  PU routers (see PIBDispatch.h)
+ */
+
+#include "StratoPIB.h"
+
+static uint8_t MessageID(SerialComm & comm, SerialMessage_t type)
+{
+    switch (type) {
+    case ASCII_MESSAGE:
+        return comm.ascii_rx.msg_id;
+    case ACK_MESSAGE:
+        return comm.ack_id;
+    case BIN_MESSAGE:
+        return comm.binary_rx.bin_id;
+    case STRING_MESSAGE:
+        return comm.string_rx.str_id;
+    default:
+        return 0;
+    }
+}
+
+static const char * MessageTypeName(SerialMessage_t type)
+{
+    switch (type) {
+    case ASCII_MESSAGE:
+        return "ASCII";
+    case ACK_MESSAGE:
+        return "ack";
+    case BIN_MESSAGE:
+        return "bin";
+    case STRING_MESSAGE:
+        return "String";
+    default:
+        return "type";
+    }
+}
+
+void StratoPIB::DispatchMessage(SerialComm & comm, SerialMessage_t type, uint8_t link,
+                                const MessageRoute_t * routes, RouteStats_t * stats, uint8_t num_routes)
+{
+    uint8_t id = MessageID(comm, type);
+
+    link_stats[link].rx_msgs++;
+    if (ASCII_MESSAGE == type && !comm.ascii_rx.checksum_valid) link_stats[link].checksum_errors++;
+    if (BIN_MESSAGE == type && !comm.binary_rx.checksum_valid) link_stats[link].checksum_errors++;
+
+    for (uint8_t i = 0; i < num_routes; i++) {
+        if (routes[i].type != type || routes[i].id != id) continue;
+
+        uint32_t start = micros();
+
+        if (NULL != routes[i].handler) {
+            (this->*routes[i].handler)();
+        } else if (NULL != routes[i].fine_msg) {
+            ZephyrLogFine(routes[i].fine_msg);
+        }
+
+        uint32_t elapsed = micros() - start;
+        stats[i].count++;
+        stats[i].total_us += elapsed;
+        if (elapsed > stats[i].max_us) stats[i].max_us = elapsed;
+        return;
+    }
+
+    link_stats[link].unknown_ids++;
+    snprintf(log_array, LOG_ARRAY_SIZE, "Unknown %s %s received: %u", (LINK_MCB == link) ? "MCB" : "PU",
+             MessageTypeName(type), id);
+    log_error(log_array);
+}
@@ -0,0 +1,121 @@
+/*
+ *  MotionModel.cpp
+ *  Author:  Alex St. Clair
+ *  Created: October 2026
+ *
+ *  This file implements the motion time model used for motion timeouts
+ *  and the PU profile timing. Each motion is modelled as a trapezoidal
+ *  velocity profile using the commanded velocity and acceleration, then
+ *  scaled by a per-type coefficient learned from completed motions.
+ */
+
+#include "StratoPIB.h"
+
+// weight given to each new measurement, and the range of ratios accepted as plausible
+#define TIME_SCALE_GAIN     0.25f
+#define TIME_SCALE_MIN      0.5f
+#define TIME_SCALE_MAX      3.0f
+
+// seconds to travel length revs accelerating and decelerating at acc rpm/s, with a top speed of vel rpm
+static float TrapezoidSeconds(float length, float vel, float acc)
+{
+    float v = vel / 60.0f; // rev/s
+    float a = acc / 60.0f; // rev/s^2
+
+    if (length <= 0.0f || v <= 0.0f) return 0.0f;
+    if (a <= 0.0f) return length / v; // no acceleration known, assume a step to full speed
+
+    // too short to reach full speed: a triangular profile
+    if (length < v * v / a) return 2.0f * sqrtf(length / a);
+
+    return length / v + v / a;
+}
+
+// seconds spent accelerating at acc rpm/s before reaching vel rpm, or the peak of a triangular profile
+static float RampSeconds(float length, float vel, float acc)
+{
+    float v = vel / 60.0f; // rev/s
+    float a = acc / 60.0f; // rev/s^2
+
+    if (length <= 0.0f || v <= 0.0f || a <= 0.0f) return 0.0f;
+
+    if (length < v * v / a) return sqrtf(length / a);
+
+    return v / a;
+}
+
+float StratoPIB::MotionRampSeconds(MCBMotion_t motion, float length, float velocity)
+{
+    switch (motion) {
+    case MOTION_REEL_OUT:
+    case MOTION_YOYO_OUT:
+        return RampSeconds(length, velocity, pibConfigs.deploy_acc.Read());
+    case MOTION_REEL_IN:
+    case MOTION_YOYO_IN:
+        return RampSeconds(length, velocity, pibConfigs.retract_acc.Read());
+    case MOTION_DOCK:
+    case MOTION_IN_NO_LW:
+        return RampSeconds(length, velocity, pibConfigs.dock_acc.Read());
+    default:
+        return 0.0f;
+    }
+}
+
+float StratoPIB::MotionSeconds(MCBMotion_t motion, float length, float velocity)
+{
+    switch (motion) {
+    case MOTION_REEL_OUT:
+    case MOTION_YOYO_OUT:
+        if (velocity <= 0.0f) velocity = pibConfigs.deploy_velocity.Read();
+        return pibConfigs.deploy_time_scale.Read() * TrapezoidSeconds(length, velocity, pibConfigs.deploy_acc.Read());
+    case MOTION_REEL_IN:
+    case MOTION_YOYO_IN:
+        if (velocity <= 0.0f) velocity = pibConfigs.retract_velocity.Read();
+        return pibConfigs.retract_time_scale.Read() * TrapezoidSeconds(length, velocity, pibConfigs.retract_acc.Read());
+    case MOTION_DOCK:
+    case MOTION_IN_NO_LW:
+        // these end against the dock, so there's nothing consistent to learn from
+        if (velocity <= 0.0f) velocity = pibConfigs.dock_velocity.Read();
+        return TrapezoidSeconds(length, velocity, pibConfigs.dock_acc.Read());
+    default:
+        return 0.0f;
+    }
+}
+
+// called when the MCB reports a motion finished, refines the time scale for its type
+void StratoPIB::LearnMotionTime()
+{
+    EEPROMData<float> * scale = NULL;
+    float modelled = 0.0f;
+
+    switch (mcb_motion) {
+    case MOTION_REEL_OUT:
+    case MOTION_YOYO_OUT:
+        scale = &pibConfigs.deploy_time_scale;
+        modelled = TrapezoidSeconds(commanded_length, commanded_velocity, pibConfigs.deploy_acc.Read());
+        break;
+    case MOTION_REEL_IN:
+    case MOTION_YOYO_IN:
+        scale = &pibConfigs.retract_time_scale;
+        modelled = TrapezoidSeconds(commanded_length, commanded_velocity, pibConfigs.retract_acc.Read());
+        break;
+    default:
+        return;
+    }
+
+    if (modelled < 1.0f) return;
+
+    float ratio = (millis() - profile_start) / (1000.0f * modelled);
+
+    // a motion far from the model is more likely an anomaly than a calibration
+    if (ratio < TIME_SCALE_MIN || ratio > TIME_SCALE_MAX) {
+        snprintf(log_array, LOG_ARRAY_SIZE, "Motion time ratio %0.2f out of range, not learned", ratio);
+        log_error(log_array);
+        return;
+    }
+
+    scale->Write(scale->Read() + TIME_SCALE_GAIN * (ratio - scale->Read()));
+
+    snprintf(log_array, LOG_ARRAY_SIZE, "Motion time ratio %0.2f, scale now %0.3f", ratio, scale->Read());
+    log_nominal(log_array);
+}
@@ -0,0 +1,87 @@
+/*
+ *  MotionMonitor.cpp
+ *  Author:  Alex St. Clair
+ *  Created: October 2026
+ *
+ *  This file implements the reel progress monitor, which estimates the
+ *  reel velocity from successive MCB motion TM positions and raises
+ *  ACTION_MOTION_STALL if it stays below stall_fraction of the commanded
+ *  velocity for stall_samples consecutive TMs. Neither the acceleration
+ *  ramp at the start of a motion nor the deceleration at its end is judged.
+ */
+
+#include "StratoPIB.h"
+
+// the MCB decelerates over the end of a motion, so the final fraction isn't judged
+#define STALL_END_FRACTION  0.05f
+
+void StratoPIB::StartMotionMonitor(float length, float velocity)
+{
+    commanded_length = length;
+    commanded_velocity = velocity;
+    monitor_ramp_ms = (uint32_t) (1000.0f * MotionRampSeconds(mcb_motion, length, velocity));
+    monitor_primed = false;
+    stall_count = 0;
+}
+
+// cancel a stalled motion, forcing the running Flight sequence to exit with an error
+bool StratoPIB::HandleMotionStall()
+{
+    if (!CheckAction(ACTION_MOTION_STALL)) return false;
+
+    CancelTimer(ACTION_MOTION_TIMEOUT);
+    SendMCBTM(CRIT, "MCB Motion stalled");
+    mcbComm.TX_ASCII(MCB_CANCEL_MOTION);
+    inst_substate = MODE_ERROR;
+    return true;
+}
+
+void StratoPIB::MonitorMotion(float position)
+{
+    uint32_t now_ms = millis();
+
+    // docking and reeling in without the level wind end against the dock by design
+    if (!mcb_motion_ongoing || mcb_dock_ongoing) return;
+
+    // the first position of a motion is the baseline
+    if (!monitor_primed) {
+        monitor_primed = true;
+        monitor_start_position = position;
+        monitor_last_position = position;
+        monitor_last_time = now_ms;
+        monitor_start_time = now_ms;
+        return;
+    }
+
+    uint32_t elapsed_ms = now_ms - monitor_last_time;
+    if (0 == elapsed_ms) return;
+
+    float velocity = 60000.0f * fabsf(position - monitor_last_position) / elapsed_ms; // rpm
+    float travelled = fabsf(position - monitor_start_position);
+    bool in_ramp = (monitor_last_time - monitor_start_time < monitor_ramp_ms); // sample began before full speed
+
+    monitor_last_position = position;
+    monitor_last_time = now_ms;
+
+    if (in_ramp) {
+        stall_count = 0;
+        return;
+    }
+
+    if (travelled >= (1.0f - STALL_END_FRACTION) * commanded_length) {
+        stall_count = 0;
+        return;
+    }
+
+    if (velocity >= pibConfigs.stall_fraction.Read() * commanded_velocity) {
+        stall_count = 0;
+        return;
+    }
+
+    if (++stall_count >= pibConfigs.stall_samples.Read()) {
+        stall_count = 0;
+        snprintf(log_array, LOG_ARRAY_SIZE, "Reel stall: %0.1f rpm at %0.1f revs", velocity, position);
+        log_error(log_array);
+        SetAction(ACTION_MOTION_STALL);
+    }
+}
@@ -13,16 +13,24 @@ PIBConfigs::PIBConfigs()
     : TeensyEEPROM(CONFIG_VERSION, BASE_ADDRESS)
     // ------------ Hard-Coded Config Defaults ------------
     , sza_minimum(105)
-    , time_trigger(UINT32_MAX)
+    , profile_calendar(EmptyCalendar())
     , sza_trigger(false)
     , profile_size(7500.0f)
     , dock_amount(200.0f)
     , dock_overshoot(100.0f)
     , redock_out(5)
     , redock_in(10)
+    , dock_window(20.0f)
     , deploy_velocity(250.0f)
     , retract_velocity(250.0f)
     , dock_velocity(80.0f)
+    , deploy_acc(25.0f)
+    , retract_acc(25.0f)
+    , dock_acc(25.0f)
+    , deploy_time_scale(1.0f)
+    , retract_time_scale(1.0f)
+    , stall_fraction(0.25f)
+    , stall_samples(5)
     , flash_temp(-20.0f)
     , heater1_temp(0.0f)
     , heater2_temp(-15.0f)
@@ -44,6 +52,11 @@ PIBConfigs::PIBConfigs()
     , profile_period(7200)
     , num_profiles(3)
     , num_redock(3)
+    , yoyo_casts(0)
+    , yoyo_top(2000.0f)
+    , profile_stops(EmptyStops())
+    , velocity_bands(EmptyBands())
+    , sequence(EmptySequence())
     , pu_docked(false)
     , real_time_mcb(false)
     , lora_tx_tm(false)
@@ -51,6 +64,16 @@ PIBConfigs::PIBConfigs()
     , profile_id(1)
     , ra_override(false)
     , pu_auto_offload(false)
+    , tsen_min_period(300)
+    , tsen_max_period(3600)
+    , hk_period(900)
+    , retry_budget(6)
+    , log_window(60)
+    , lora_status_period(600)
+    , lora_sf(10)
+    , lora_bandwidth(250000)
+    , lora_power(14)
+    , lora_margin(10.0f)
     // ----------------------------------------------------
 { }
 
@@ -59,16 +82,24 @@ void PIBConfigs::RegisterAll()
     bool success = true;
 
     success &= Register(&sza_minimum);
-    success &= Register(&time_trigger);
+    success &= Register(&profile_calendar);
     success &= Register(&sza_trigger);
     success &= Register(&profile_size);
     success &= Register(&dock_amount);
     success &= Register(&dock_overshoot);
     success &= Register(&redock_out);
     success &= Register(&redock_in);
+    success &= Register(&dock_window);
     success &= Register(&deploy_velocity);
     success &= Register(&retract_velocity);
     success &= Register(&dock_velocity);
+    success &= Register(&deploy_acc);
+    success &= Register(&retract_acc);
+    success &= Register(&dock_acc);
+    success &= Register(&deploy_time_scale);
+    success &= Register(&retract_time_scale);
+    success &= Register(&stall_fraction);
+    success &= Register(&stall_samples);
     success &= Register(&flash_temp);
     success &= Register(&heater1_temp);
     success &= Register(&heater2_temp);
@@ -90,6 +121,11 @@ void PIBConfigs::RegisterAll()
     success &= Register(&profile_period);
     success &= Register(&num_profiles);
     success &= Register(&num_redock);
+    success &= Register(&yoyo_casts);
+    success &= Register(&yoyo_top);
+    success &= Register(&profile_stops);
+    success &= Register(&velocity_bands);
+    success &= Register(&sequence);
     success &= Register(&pu_docked);
     success &= Register(&real_time_mcb);
     success &= Register(&lora_tx_tm);
@@ -97,8 +133,65 @@ void PIBConfigs::RegisterAll()
     success &= Register(&profile_id);
     success &= Register(&ra_override);
     success &= Register(&pu_auto_offload);
+    success &= Register(&tsen_min_period);
+    success &= Register(&tsen_max_period);
+    success &= Register(&hk_period);
+    success &= Register(&retry_budget);
+    success &= Register(&log_window);
+    success &= Register(&lora_status_period);
+    success &= Register(&lora_sf);
+    success &= Register(&lora_bandwidth);
+    success &= Register(&lora_power);
+    success &= Register(&lora_margin);
 
     if (!success) {
         debug_serial->println("Error registering EEPROM configs");
     }
-}
\ No newline at end of file
+}
+
+ProfileCalendar_t PIBConfigs::EmptyCalendar()
+{
+    ProfileCalendar_t calendar;
+
+    for (int i = 0; i < CALENDAR_SIZE; i++) {
+        calendar.entries[i] = {UINT32_MAX, 0.0f, 0, 0};
+    }
+
+    return calendar;
+}
+
+ProfileStops_t PIBConfigs::EmptyStops()
+{
+    ProfileStops_t stops;
+
+    stops.num_stops = 0;
+    for (int i = 0; i < MAX_PROFILE_STOPS; i++) {
+        stops.stops[i] = {0.0f, 0.0f, 0};
+    }
+
+    return stops;
+}
+
+VelocityBands_t PIBConfigs::EmptyBands()
+{
+    VelocityBands_t bands;
+
+    bands.num_bands = 0;
+    for (int i = 0; i < MAX_VELOCITY_BANDS; i++) {
+        bands.bands[i] = {0.0f, 0.0f, 0.0f};
+    }
+
+    return bands;
+}
+
+Sequence_t PIBConfigs::EmptySequence()
+{
+    Sequence_t sequence;
+
+    sequence.length = 0;
+    for (int i = 0; i < SEQUENCE_SIZE; i++) {
+        sequence.code[i] = SEQ_END;
+    }
+
+    return sequence;
+}
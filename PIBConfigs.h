@@ -16,6 +16,52 @@
 #define PIBCONFIGS_H
 
 #include "TeensyEEPROM.h"
+#include "PIBSequence.h"
+
+#define CALENDAR_SIZE   8
+
+// one night of time-triggered profiles, zero count, period, or size uses the current config
+struct CalendarEntry_t {
+    uint32_t trigger;       // UNIX time, UINT32_MAX if the entry is empty
+    float profile_size;     // revolutions
+    uint16_t profile_period;
+    uint8_t num_profiles;
+};
+
+// upcoming entries in trigger order, empty entries last
+struct ProfileCalendar_t {
+    CalendarEntry_t entries[CALENDAR_SIZE];
+};
+
+#define MAX_PROFILE_STOPS   6
+
+// a stop on the final ascent, reached at velocity (0 for retract_velocity) and held for dwell seconds
+struct ProfileStop_t {
+    float depth;            // revolutions deployed
+    float velocity;         // rpm
+    uint16_t dwell;
+};
+
+// stops from deepest to shallowest
+struct ProfileStops_t {
+    uint8_t num_stops;
+    ProfileStop_t stops[MAX_PROFILE_STOPS];
+};
+
+#define MAX_VELOCITY_BANDS  3
+
+// a layer (in revolutions deployed, top < bottom) crossed at its own velocity on every deploy and retract
+struct VelocityBand_t {
+    float top;
+    float bottom;
+    float velocity;         // rpm
+};
+
+// non-overlapping bands, in the order added
+struct VelocityBands_t {
+    uint8_t num_bands;
+    VelocityBand_t bands[MAX_VELOCITY_BANDS];
+};
 
 class PIBConfigs : public TeensyEEPROM {
 private:
@@ -24,15 +70,20 @@ private:
 public:
     PIBConfigs();
 
+    static ProfileCalendar_t EmptyCalendar();
+    static ProfileStops_t EmptyStops();
+    static VelocityBands_t EmptyBands();
+    static Sequence_t EmptySequence();
+
     // constants, manually change version number here to force update
-    static const uint16_t CONFIG_VERSION = 0x5C02;
+    static const uint16_t CONFIG_VERSION = 0x5C10;
     static const uint16_t BASE_ADDRESS = 0x0000;
 
     // ------------------ Configurations ------------------
 
     // profile triggers
     EEPROMData<float> sza_minimum;
-    EEPROMData<uint32_t> time_trigger;
+    EEPROMData<ProfileCalendar_t> profile_calendar;
     EEPROMData<bool> sza_trigger; // true if SZA triggers profile, false if profile_time
 
     // profile sizing (in revolutions)
@@ -41,12 +92,26 @@ public:
     EEPROMData<float> dock_overshoot;
     EEPROMData<float> redock_out;
     EEPROMData<float> redock_in;
+    EEPROMData<float> dock_window; // tolerance on the reel position after reel in
 
     // profile speeds (in rpm)
     EEPROMData<float> deploy_velocity;
     EEPROMData<float> retract_velocity;
     EEPROMData<float> dock_velocity;
 
+    // profile accelerations (in rpm/s), mirrored from the values sent to the MCB
+    EEPROMData<float> deploy_acc;
+    EEPROMData<float> retract_acc;
+    EEPROMData<float> dock_acc;
+
+    // learned ratio of measured to modelled motion time
+    EEPROMData<float> deploy_time_scale;
+    EEPROMData<float> retract_time_scale;
+
+    // stall detection: fraction of commanded velocity, and consecutive motion TMs below it
+    EEPROMData<float> stall_fraction;
+    EEPROMData<uint8_t> stall_samples;
+
     // PU configuration
     EEPROMData<float> flash_temp;
     EEPROMData<float> heater1_temp;
@@ -74,6 +139,19 @@ public:
     EEPROMData<uint8_t> num_profiles; // per night
     EEPROMData<uint8_t> num_redock;   // before erroring out
 
+    // yo-yo casts between profile_size and yoyo_top (revs deployed) before the final retract, 0 to disable
+    EEPROMData<uint8_t> yoyo_casts;
+    EEPROMData<float> yoyo_top;
+
+    // stepped ascent, empty for a continuous retract
+    EEPROMData<ProfileStops_t> profile_stops;
+
+    // velocity schedule, empty for a single deploy and retract velocity
+    EEPROMData<VelocityBands_t> velocity_bands;
+
+    // uploaded flight sequence, run with RUNSEQUENCE
+    EEPROMData<Sequence_t> sequence;
+
     // PU tracking
     EEPROMData<bool> pu_docked;
 
@@ -87,6 +165,28 @@ public:
     EEPROMData<uint16_t> profile_id;
     EEPROMData<bool> ra_override;
     EEPROMData<bool> pu_auto_offload;
+
+    // adaptive TSEN polling bounds (seconds)
+    EEPROMData<uint16_t> tsen_min_period;
+    EEPROMData<uint16_t> tsen_max_period;
+
+    // housekeeping TM period (seconds), 0 to disable
+    EEPROMData<uint16_t> hk_period;
+
+    // resends each peer may use before its commands fail fast
+    EEPROMData<uint8_t> retry_budget;
+
+    // seconds identical Zephyr log messages are folded after the first (0 to disable)
+    EEPROMData<uint16_t> log_window;
+
+    // seconds LoRa status packets are batched before sending as one TM (0 to forward each)
+    EEPROMData<uint16_t> lora_status_period;
+
+    // PIB LoRa radio settings, and the SNR margin (dB) kept by the recommended spreading factor
+    EEPROMData<uint8_t> lora_sf;
+    EEPROMData<uint32_t> lora_bandwidth;
+    EEPROMData<uint8_t> lora_power;
+    EEPROMData<float> lora_margin;
     // ----------------------------------------------------
 
 };
@@ -0,0 +1,36 @@
+/*
+ *  PIBDispatch.h
+ *  Author:  Alex St. Clair
+ *  Created: October 2026
+ *
+ *  Types for the table-driven MCB and PU message dispatch. Each router has
+ *  a compile-time table of routes keyed on the SerialComm message type and
+ *  ID. A route either names a StratoPIB handler or, for messages that only
+ *  need reporting, a string to send with ZephyrLogFine. Every route counts
+ *  its invocations and handler time, and a message with no route is
+ *  counted and logged the same way on both links.
+ */
+
+#ifndef PIBDISPATCH_H
+#define PIBDISPATCH_H
+
+#include "Arduino.h"
+
+class StratoPIB;
+
+typedef void (StratoPIB::*MessageHandler_t)();
+
+struct MessageRoute_t {
+    uint8_t type;               // SerialMessage_t
+    uint8_t id;
+    MessageHandler_t handler;   // NULL to only log
+    const char * fine_msg;      // sent with ZephyrLogFine if non-NULL
+};
+
+struct RouteStats_t {
+    uint32_t count;
+    uint32_t total_us;
+    uint32_t max_us;
+};
+
+#endif /* PIBDISPATCH_H */
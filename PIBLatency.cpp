@@ -0,0 +1,91 @@
+/*
+ *  PIBLatency.cpp
+ *  Author:  Alex St. Clair
+ *  Created: October 2026
+ *
+ *  This class tracks command round-trip times and adaptive resend timeouts
+ */
+
+#include "PIBLatency.h"
+
+PIBLatency::PIBLatency()
+{
+    for (uint8_t i = 0; i < NUM_RTT_CLASSES; i++) {
+        stats[i] = {0, 0, 0, 0, 0};
+        sent_ms[i] = 0;
+        received_ms[i] = 0;
+        pending[i] = false;
+        received[i] = false;
+    }
+}
+
+void PIBLatency::Sent(uint8_t rtt_class, bool resend)
+{
+    if (rtt_class >= NUM_RTT_CLASSES) return;
+
+    pending[rtt_class] = !resend;
+    received[rtt_class] = false;
+    sent_ms[rtt_class] = millis();
+}
+
+void PIBLatency::Received(uint8_t rtt_class)
+{
+    if (rtt_class >= NUM_RTT_CLASSES) return;
+
+    // keep the first arrival, a repeated ack isn't a new round trip
+    if (!pending[rtt_class] || received[rtt_class]) return;
+
+    received[rtt_class] = true;
+    received_ms[rtt_class] = millis();
+}
+
+void PIBLatency::Acked(uint8_t rtt_class)
+{
+    if (rtt_class >= NUM_RTT_CLASSES) return;
+
+    RTTStats_t & s = stats[rtt_class];
+
+    if (!pending[rtt_class]) return;
+    pending[rtt_class] = false;
+
+    // fall back on the current time for acks that weren't noted on arrival
+    uint32_t ack_ms = received[rtt_class] ? received_ms[rtt_class] : millis();
+    uint32_t rtt = ack_ms - sent_ms[rtt_class];
+    received[rtt_class] = false;
+
+    if (0 == s.samples) {
+        s.srtt_ms = rtt;
+        s.rttvar_ms = rtt / 2;
+    } else {
+        // gains of 1/8 and 1/4, in integer arithmetic
+        uint32_t deviation = (rtt > s.srtt_ms) ? rtt - s.srtt_ms : s.srtt_ms - rtt;
+        s.rttvar_ms = s.rttvar_ms - s.rttvar_ms / 4 + deviation / 4;
+        s.srtt_ms = s.srtt_ms - s.srtt_ms / 8 + rtt / 8;
+    }
+
+    if (rtt > s.max_ms) s.max_ms = rtt;
+    if (s.samples < UINT16_MAX) s.samples++;
+}
+
+void PIBLatency::TimedOut(uint8_t rtt_class)
+{
+    if (rtt_class >= NUM_RTT_CLASSES) return;
+
+    pending[rtt_class] = false;
+    received[rtt_class] = false;
+    if (stats[rtt_class].timeouts < UINT16_MAX) stats[rtt_class].timeouts++;
+}
+
+uint16_t PIBLatency::Timeout(uint8_t rtt_class, uint16_t minimum, uint16_t ceiling)
+{
+    if (rtt_class >= NUM_RTT_CLASSES || 0 == stats[rtt_class].samples) return ceiling;
+
+    const RTTStats_t & s = stats[rtt_class];
+
+    // round up to whole seconds
+    uint32_t timeout = (s.srtt_ms + 4 * s.rttvar_ms + 999) / 1000;
+    if (timeout < RTT_MIN_TIMEOUT) timeout = RTT_MIN_TIMEOUT;
+    if (timeout < minimum) timeout = minimum;
+
+    return (timeout < ceiling) ? timeout : ceiling;
+}
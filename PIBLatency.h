@@ -0,0 +1,73 @@
+/*
+ *  PIBLatency.h
+ *  Author:  Alex St. Clair
+ *  Created: October 2026
+ *
+ *  This class tracks command round-trip times and derives resend
+ *  timeouts from them, after the TCP retransmission timer (RFC 6298): a
+ *  smoothed RTT and mean deviation per command class, with the
+ *  timeout set to SRTT + 4 * RTTVAR. A resent command gives no sample
+ *  (Karn's rule), since its ack can't be matched to either send. Backoff
+ *  for resends is left to the retry policy (PIBRetry).
+ *
+ *  The state machines only see an ack on their next pass, up to a loop
+ *  period after the router handled it, so the routers note the arrival
+ *  time with Received() and the sample is taken from that.
+ *
+ *  Timeouts are in whole seconds to match the timer wheel, and are held
+ *  between a floor and ceiling from the caller: the ceiling is the old
+ *  fixed timeout, so an unresponsive peer costs no more than it did
+ *  before, and the floor keeps commands that must not be duplicated
+ *  from being resent while a slow ack is still on its way.
+ */
+
+#ifndef PIBLATENCY_H
+#define PIBLATENCY_H
+
+#include "Arduino.h"
+
+// shortest adaptive timeout (s), covering the 1 Hz loop and timer granularity
+#define RTT_MIN_TIMEOUT     2
+
+// command classes tracked, classes out of range are ignored
+#define NUM_RTT_CLASSES     12
+#define RTT_NONE            0xFF
+
+struct RTTStats_t {
+    uint32_t srtt_ms;
+    uint32_t rttvar_ms;
+    uint32_t max_ms;
+    uint16_t samples;
+    uint16_t timeouts;
+};
+
+class PIBLatency {
+public:
+    PIBLatency();
+
+    // note a command sent, a resend discards any measurement in progress
+    void Sent(uint8_t rtt_class, bool resend);
+
+    // note an ack's arrival in a router, before the state machine consumes it
+    void Received(uint8_t rtt_class);
+
+    // note an ack, taking a sample if a first send is outstanding
+    void Acked(uint8_t rtt_class);
+
+    // note a resend timer firing
+    void TimedOut(uint8_t rtt_class);
+
+    // resend timeout in seconds between minimum and ceiling (ceiling is used until there are samples)
+    uint16_t Timeout(uint8_t rtt_class, uint16_t minimum, uint16_t ceiling);
+
+    const RTTStats_t & Stats(uint8_t rtt_class) { return stats[rtt_class]; }
+
+private:
+    RTTStats_t stats[NUM_RTT_CLASSES];
+    uint32_t sent_ms[NUM_RTT_CLASSES];
+    uint32_t received_ms[NUM_RTT_CLASSES];
+    bool pending[NUM_RTT_CLASSES];
+    bool received[NUM_RTT_CLASSES];
+};
+
+#endif /* PIBLATENCY_H */
@@ -0,0 +1,56 @@
+/*
+ *  PIBLinkStats.cpp
+ *  Author:  Alex St. Clair
+ *  Created: October 2026
+ *
+ *  This class counts the bytes passing through a link's serial port
+ */
+
+#include "PIBLinkStats.h"
+
+PIBLinkStream::PIBLinkStream(Stream * port, LinkStats_t * stats)
+    : port(port)
+    , stats(stats)
+{
+}
+
+int PIBLinkStream::available()
+{
+    return port->available();
+}
+
+int PIBLinkStream::read()
+{
+    int b = port->read();
+    if (b >= 0) stats->rx_bytes++;
+    return b;
+}
+
+int PIBLinkStream::peek()
+{
+    return port->peek();
+}
+
+size_t PIBLinkStream::write(uint8_t b)
+{
+    size_t written = port->write(b);
+    stats->tx_bytes += written;
+    return written;
+}
+
+size_t PIBLinkStream::write(const uint8_t * buffer, size_t size)
+{
+    size_t written = port->write(buffer, size);
+    stats->tx_bytes += written;
+    return written;
+}
+
+int PIBLinkStream::availableForWrite()
+{
+    return port->availableForWrite();
+}
+
+void PIBLinkStream::flush()
+{
+    port->flush();
+}
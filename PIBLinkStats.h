@@ -0,0 +1,72 @@
+/*
+ *  PIBLinkStats.h
+ *  Author:  Alex St. Clair
+ *  Created: October 2026
+ *
+ *  Traffic and error counters for each of the PIB's links. The Zephyr,
+ *  MCB, and PU ports are each wrapped in a PIBLinkStream, which passes
+ *  everything through to the serial port and counts the bytes in each
+ *  direction, so every TX path is covered without touching its call
+ *  site. Messages, checksum failures, NAKs, unknown IDs, and resends are
+ *  counted by the routers and state machines, which know the protocol.
+ */
+
+#ifndef PIBLINKSTATS_H
+#define PIBLINKSTATS_H
+
+#include "Arduino.h"
+#include "PIBRetry.h"
+
+// links with the retry peers first, so a policy's peer indexes its link
+enum LinkID_t : uint8_t {
+    LINK_ZEPHYR = PEER_ZEPHYR,
+    LINK_MCB = PEER_MCB,
+    LINK_PU = PEER_PU,
+    LINK_LORA,
+    NUM_LINKS
+};
+
+// categories of Zephyr TX, anything uncategorized (logs, IMR, TC acks) is the remainder
+enum ZephyrCategory_t : uint8_t {
+    ZCAT_MCB_TM,
+    ZCAT_TSEN,
+    ZCAT_PROFILE,
+    ZCAT_LORA_TM,
+    ZCAT_EEPROM,
+    ZCAT_HOUSEKEEPING,
+    ZCAT_RA,
+    ZCAT_SAFETY,
+    NUM_ZEPHYR_CATEGORIES
+};
+
+struct LinkStats_t {
+    uint32_t rx_msgs;
+    uint32_t rx_bytes;
+    uint32_t tx_bytes;
+    uint32_t checksum_errors;
+    uint32_t naks;              // received from Zephyr, or sent to the PU for rejected records
+    uint32_t unknown_ids;
+    uint32_t resends;
+};
+
+class PIBLinkStream : public Stream {
+public:
+    PIBLinkStream(Stream * port, LinkStats_t * stats);
+
+    int available();
+    int read();
+    int peek();
+    size_t write(uint8_t b);
+    size_t write(const uint8_t * buffer, size_t size);
+    int availableForWrite();
+    void flush();
+
+    // running count of bytes written, to attribute a message's bytes to its category
+    uint32_t TXBytes() { return stats->tx_bytes; }
+
+private:
+    Stream * port;
+    LinkStats_t * stats;
+};
+
+#endif /* PIBLINKSTATS_H */
@@ -0,0 +1,73 @@
+/*
+ *  PIBLoRaLink.cpp
+ *  Author:  Alex St. Clair
+ *  Created: October 2026
+ *
+ *  This class tracks LoRa link quality and recommends a spreading factor
+ */
+
+#include "PIBLoRaLink.h"
+
+// SX127x demodulation SNR limits (dB) for SF7 to SF12
+float PIBLoRaLink::SNRLimit(uint8_t sf)
+{
+    static const float limits[LORA_SF_MAX - LORA_SF_MIN + 1] = {-7.5f, -10.0f, -12.5f, -15.0f, -17.5f, -20.0f};
+
+    if (sf < LORA_SF_MIN) sf = LORA_SF_MIN;
+    if (sf > LORA_SF_MAX) sf = LORA_SF_MAX;
+
+    return limits[sf - LORA_SF_MIN];
+}
+
+void PIBLoRaLink::Reset(uint8_t sf, uint32_t now_s)
+{
+    recommended = sf;
+    snr_avg = 0.0f;
+    rssi_avg = 0.0f;
+    packets = 0;
+    fresh = false;
+    last_contact = now_s;
+    last_step = now_s;
+}
+
+void PIBLoRaLink::Packet(int rssi, float snr, uint32_t now_s)
+{
+    if (0 == packets) {
+        snr_avg = snr;
+        rssi_avg = (float) rssi;
+    } else {
+        // gain of 1/4, to follow the PU's descent within a few packets
+        snr_avg += (snr - snr_avg) / 4.0f;
+        rssi_avg += ((float) rssi - rssi_avg) / 4.0f;
+    }
+
+    if (packets < UINT16_MAX) packets++;
+    fresh = true;
+    last_contact = now_s;
+}
+
+bool PIBLoRaLink::Update(uint32_t now_s, float margin_db, uint32_t contact_timeout)
+{
+    uint8_t previous = recommended;
+
+    if (now_s - last_contact >= contact_timeout) {
+        // lost contact: fall back one SF per timeout
+        if (now_s - last_step >= contact_timeout && recommended < LORA_SF_MAX) {
+            recommended++;
+            last_step = now_s;
+        }
+    } else if (fresh) {
+        fresh = false;
+
+        if (snr_avg - SNRLimit(recommended) < margin_db) {
+            if (recommended < LORA_SF_MAX) recommended++;
+        } else if (recommended > LORA_SF_MIN &&
+                   snr_avg - SNRLimit(recommended - 1) >= margin_db + LORA_HYSTERESIS_DB) {
+            recommended--;
+        }
+
+        last_step = now_s;
+    }
+
+    return previous != recommended;
+}
@@ -0,0 +1,52 @@
+/*
+ *  PIBLoRaLink.h
+ *  Author:  Alex St. Clair
+ *  Created: October 2026
+ *
+ *  This class tracks the quality of the PU's LoRa link over a relay
+ *  session (from undock) and recommends a spreading factor. The SNR of
+ *  each packet is smoothed, and the margin at a spreading factor is the
+ *  smoothed SNR less that factor's demodulation limit. The recommendation
+ *  steps up one SF as soon as the margin falls short, and down one SF per
+ *  packet only once the lower factor would clear the margin plus a
+ *  hysteresis. If contact is lost, it steps up one SF per contact timeout
+ *  until SF12, a fixed schedule a peer can follow without the link.
+ */
+
+#ifndef PIBLORALINK_H
+#define PIBLORALINK_H
+
+#include "Arduino.h"
+
+#define LORA_SF_MIN         7
+#define LORA_SF_MAX         12
+#define LORA_HYSTERESIS_DB  3.0f
+
+class PIBLoRaLink {
+public:
+    // start a session at the radio's current spreading factor
+    void Reset(uint8_t sf, uint32_t now_s);
+
+    void Packet(int rssi, float snr, uint32_t now_s);
+
+    // update the recommendation, true if it changed
+    bool Update(uint32_t now_s, float margin_db, uint32_t contact_timeout);
+
+    uint8_t Recommended() { return recommended; }
+    float SNR() { return snr_avg; }
+    float RSSI() { return rssi_avg; }
+    uint16_t Packets() { return packets; }
+
+private:
+    static float SNRLimit(uint8_t sf);
+
+    uint8_t recommended = 10;
+    float snr_avg = 0.0f;
+    float rssi_avg = 0.0f;
+    uint16_t packets = 0;
+    bool fresh = false;     // a packet since the last update
+    uint32_t last_contact = 0;
+    uint32_t last_step = 0;
+};
+
+#endif /* PIBLORALINK_H */
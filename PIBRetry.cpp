@@ -0,0 +1,81 @@
+/*
+ *  PIBRetry.cpp
+ *  Author:  Alex St. Clair
+ *  Created: October 2026
+ *
+ *  This class applies the retry policy for every command the PIB resends
+ */
+
+#include "PIBRetry.h"
+
+PIBRetry::PIBRetry(const RetryPolicy_t * policies, uint8_t num_classes)
+    : policies(policies)
+    , num_classes((num_classes < NUM_RETRY_CLASSES) ? num_classes : NUM_RETRY_CLASSES)
+{
+    for (uint8_t i = 0; i < NUM_RETRY_CLASSES; i++) {
+        stats[i] = {0, 0, 0};
+    }
+
+    for (uint8_t i = 0; i < NUM_RETRY_PEERS; i++) {
+        budget[i] = 0;
+    }
+}
+
+void PIBRetry::SetBudget(uint8_t new_budget)
+{
+    max_budget = new_budget;
+
+    for (uint8_t i = 0; i < NUM_RETRY_PEERS; i++) {
+        budget[i] = max_budget;
+    }
+}
+
+uint8_t PIBRetry::Attempts(uint8_t retry_class)
+{
+    if (!Valid(retry_class)) return 1;
+
+    const RetryPolicy_t & policy = policies[retry_class];
+
+    // an unlimited policy (safety) is never cut short
+    if (0 != policy.max_attempts && 0 == budget[policy.peer]) {
+        if (stats[retry_class].fail_fast < UINT16_MAX) stats[retry_class].fail_fast++;
+        return 1;
+    }
+
+    return policy.max_attempts;
+}
+
+uint16_t PIBRetry::Backoff(uint8_t retry_class, uint16_t base, uint8_t attempt)
+{
+    if (!Valid(retry_class)) return base;
+
+    uint32_t timeout = base;
+    uint16_t cap = policies[retry_class].max_timeout;
+
+    while (attempt-- > 0 && timeout < cap) timeout <<= 1;
+    if (timeout > cap) timeout = cap;
+
+    return (uint16_t) (timeout + random(0, timeout / 4 + 1));
+}
+
+void PIBRetry::Retried(uint8_t retry_class)
+{
+    if (!Valid(retry_class)) return;
+
+    if (stats[retry_class].retries < UINT16_MAX) stats[retry_class].retries++;
+    if (0 != budget[policies[retry_class].peer]) budget[policies[retry_class].peer]--;
+}
+
+void PIBRetry::Succeeded(uint8_t retry_class)
+{
+    if (!Valid(retry_class)) return;
+
+    if (budget[policies[retry_class].peer] < max_budget) budget[policies[retry_class].peer]++;
+}
+
+void PIBRetry::Failed(uint8_t retry_class)
+{
+    if (!Valid(retry_class)) return;
+
+    if (stats[retry_class].failures < UINT16_MAX) stats[retry_class].failures++;
+}
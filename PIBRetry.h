@@ -0,0 +1,80 @@
+/*
+ *  PIBRetry.h
+ *  Author:  Alex St. Clair
+ *  Created: October 2026
+ *
+ *  This class applies the retry policy for every command the PIB resends.
+ *  Each command class (one per resend action) has a policy giving the
+ *  peer it's sent to, its attempt budget, and the cap on its backoff.
+ *  Each resend doubles the timeout, up to the cap, and adds up to 25%
+ *  random jitter so repeated resends don't stay in lockstep with the
+ *  peer's own timing.
+ *
+ *  Each peer also has a shared error budget. A resend spends one token
+ *  and an acknowledged command earns one back. While a peer's budget is
+ *  spent, its commands get a single attempt, so a dead peer fails fast
+ *  instead of costing every sequence its full set of timeouts.
+ */
+
+#ifndef PIBRETRY_H
+#define PIBRETRY_H
+
+#include "Arduino.h"
+
+// command classes with a policy, must cover every resend action
+#define NUM_RETRY_CLASSES   12
+
+enum RetryPeer_t : uint8_t {
+    PEER_ZEPHYR,
+    PEER_MCB,
+    PEER_PU,
+    NUM_RETRY_PEERS
+};
+
+struct RetryPolicy_t {
+    uint8_t peer;
+    uint8_t max_attempts;   // sends before giving up, 0 for unlimited
+    uint16_t min_timeout;   // seconds, floor on the adaptive timeout
+    uint16_t timeout;       // seconds before the first resend, and the ceiling on the adaptive timeout
+    uint16_t max_timeout;   // seconds, cap on the backoff
+};
+
+struct RetryStats_t {
+    uint16_t retries;
+    uint16_t failures;      // attempts exhausted
+    uint16_t fail_fast;     // single attempts because the peer's budget was spent
+};
+
+class PIBRetry {
+public:
+    PIBRetry(const RetryPolicy_t * policies, uint8_t num_classes);
+
+    // resize every peer's error budget, refilling it
+    void SetBudget(uint8_t budget);
+
+    // attempts allowed for a command, counting a fail-fast if the peer's budget is spent
+    uint8_t Attempts(uint8_t retry_class);
+
+    // timeout for an attempt (0 for the first send) starting from base seconds
+    uint16_t Backoff(uint8_t retry_class, uint16_t base, uint8_t attempt);
+
+    // outcomes: a resend spends the peer's budget, an ack earns it back
+    void Retried(uint8_t retry_class);
+    void Succeeded(uint8_t retry_class);
+    void Failed(uint8_t retry_class);
+
+    const RetryPolicy_t & Policy(uint8_t retry_class) { return policies[retry_class]; }
+    const RetryStats_t & Stats(uint8_t retry_class) { return stats[retry_class]; }
+    uint8_t Budget(uint8_t peer) { return (peer < NUM_RETRY_PEERS) ? budget[peer] : 0; }
+
+private:
+    bool Valid(uint8_t retry_class) { return retry_class < num_classes; }
+
+    const RetryPolicy_t * policies;
+    uint8_t num_classes;
+    RetryStats_t stats[NUM_RETRY_CLASSES];
+    uint8_t budget[NUM_RETRY_PEERS];
+    uint8_t max_budget = 0;
+};
+
+#endif /* PIBRETRY_H */
@@ -0,0 +1,78 @@
+/*
+ *  PIBSequence.cpp
+ *  Author:  Alex St. Clair
+ *  Created: October 2026
+ *
+ *  This file implements the checks on uploaded flight sequences
+ */
+
+#include "PIBSequence.h"
+
+static const uint8_t operand_bytes[NUM_SEQ_OPS] = {
+    0,  // SEQ_END
+    5,  // SEQ_MOTION
+    0,  // SEQ_CHECK_PU
+    0,  // SEQ_TSEN
+    0,  // SEQ_OFFLOAD
+    0,  // SEQ_REDOCK
+    0,  // SEQ_PROFILE
+    0,  // SEQ_DOCKED_PROFILE
+    0,  // SEQ_PU_WARMUP
+    2,  // SEQ_WAIT
+    3,  // SEQ_WAIT_ACTION
+    1,  // SEQ_SET_ACTION
+    1,  // SEQ_TM
+    1,  // SEQ_SET_COUNT
+    1,  // SEQ_LOOP
+    1,  // SEQ_JUMP
+    1,  // SEQ_JUMP_IF
+};
+
+static bool AllowedAction(uint8_t action, const uint8_t * actions, uint8_t num_actions)
+{
+    for (uint8_t i = 0; i < num_actions; i++) {
+        if (actions[i] == action) return true;
+    }
+
+    return false;
+}
+
+uint8_t SequenceOperandBytes(uint8_t op)
+{
+    return (op < NUM_SEQ_OPS) ? operand_bytes[op] : 0;
+}
+
+bool ValidateSequence(const Sequence_t & sequence, const uint8_t * actions, uint8_t num_actions)
+{
+    bool boundary[SEQUENCE_SIZE] = {false};
+    uint16_t pc = 0;
+
+    if (sequence.length > SEQUENCE_SIZE) return false;
+
+    // first pass: decode every instruction, marking where each one starts
+    while (pc < sequence.length) {
+        uint8_t op = sequence.code[pc];
+
+        if (op >= NUM_SEQ_OPS || pc + 1 + operand_bytes[op] > sequence.length) return false;
+
+        if ((SEQ_WAIT_ACTION == op || SEQ_SET_ACTION == op) && !AllowedAction(sequence.code[pc + 1], actions, num_actions)) return false;
+
+        boundary[pc] = true;
+        pc += 1 + operand_bytes[op];
+    }
+
+    // second pass: jumps must land on an instruction (or the end, which finishes the sequence)
+    pc = 0;
+    while (pc < sequence.length) {
+        uint8_t op = sequence.code[pc];
+
+        if (SEQ_LOOP == op || SEQ_JUMP == op || SEQ_JUMP_IF == op) {
+            uint8_t target = sequence.code[pc + 1];
+            if (target > sequence.length || (target < sequence.length && !boundary[target])) return false;
+        }
+
+        pc += 1 + operand_bytes[op];
+    }
+
+    return true;
+}
@@ -0,0 +1,58 @@
+/*
+ *  PIBSequence.h
+ *  Author:  Alex St. Clair
+ *  Created: October 2026
+ *
+ *  This file declares the bytecode for flight sequences uploaded by
+ *  telecommand and run by Flight_Sequence. A sequence is a string of
+ *  one-byte opcodes, each followed by a fixed number of little-endian
+ *  operand bytes. Jump targets are byte offsets into the sequence.
+ *
+ *  Blocking instructions hand off to the existing Flight_* sequences (or
+ *  a timer), so a sequence gets the same RA handshakes, resends, and
+ *  fault handling as the built-in commands. Other instructions run up to
+ *  SEQUENCE_BUDGET per loop, so even a tight loop can't stall the PIB.
+ */
+
+#ifndef PIBSEQUENCE_H
+#define PIBSEQUENCE_H
+
+#include "Arduino.h"
+
+#define SEQUENCE_SIZE       128
+#define SEQUENCE_CHUNK      8   // bytes per upload telecommand
+#define SEQUENCE_BUDGET     8   // instructions per loop
+
+enum SequenceOp_t : uint8_t {
+    SEQ_END,            // finish the sequence
+    SEQ_MOTION,         // u8 motion, f32 revs: RA, motion, and TM as for a manual motion
+    SEQ_CHECK_PU,       // run Flight_CheckPU
+    SEQ_TSEN,           // run Flight_TSEN
+    SEQ_OFFLOAD,        // run Flight_PUOffload
+    SEQ_REDOCK,         // run Flight_ReDock with redock_out and redock_in
+    SEQ_PROFILE,        // run Flight_Profile
+    SEQ_DOCKED_PROFILE, // run Flight_DockedProfile
+    SEQ_PU_WARMUP,      // send the PU warmup command and wait for the ack
+    SEQ_WAIT,           // u16 seconds
+    SEQ_WAIT_ACTION,    // u8 action, u16 timeout seconds: the condition is set if the action arrived
+    SEQ_SET_ACTION,     // u8 action
+    SEQ_TM,             // u8 marker: FINE Zephyr message
+    SEQ_SET_COUNT,      // u8 count
+    SEQ_LOOP,           // u8 target: decrement the count, jump while it's non-zero
+    SEQ_JUMP,           // u8 target
+    SEQ_JUMP_IF,        // u8 target: jump if the condition is set
+    NUM_SEQ_OPS
+};
+
+struct Sequence_t {
+    uint8_t length;
+    uint8_t code[SEQUENCE_SIZE];
+};
+
+// number of operand bytes following an opcode
+uint8_t SequenceOperandBytes(uint8_t op);
+
+// true if every instruction is complete, every jump lands on an instruction, and every action is in actions
+bool ValidateSequence(const Sequence_t & sequence, const uint8_t * actions, uint8_t num_actions);
+
+#endif /* PIBSEQUENCE_H */
@@ -0,0 +1,83 @@
+/*
+ *  PIBStateMachine.cpp
+ *  Author:  Alex St. Clair
+ *  Created: October 2026
+ *
+ *  This file implements the table-driven engine behind the Flight_* state machines
+ */
+
+#include "PIBStateMachine.h"
+
+SMExitHook_t StateMachine::exit_hook = NULL;
+void * StateMachine::exit_owner = NULL;
+
+StateMachine::StateMachine(const SMState_t * table, uint8_t num_states, uint32_t * residence_ms, uint16_t * entries)
+    : table(table)
+    , num_states(num_states)
+    , residence_ms(residence_ms)
+    , entries(entries)
+{
+}
+
+void StateMachine::SetExitHook(SMExitHook_t hook, void * owner)
+{
+    exit_hook = hook;
+    exit_owner = owner;
+}
+
+void StateMachine::Start(uint8_t initial)
+{
+    Transition(initial);
+}
+
+void StateMachine::Transition(uint8_t next_state)
+{
+    // a machine that has never been entered has no state to exit
+    if (0 != transitions && NULL != exit_hook) exit_hook(exit_owner, table[state].resend_action);
+
+    attempts = 0;
+    Enter(next_state);
+}
+
+bool StateMachine::Entered()
+{
+    if (entry_pending) {
+        entry_pending = false;
+        return true;
+    }
+
+    return false;
+}
+
+bool StateMachine::Retry(uint8_t max_attempts)
+{
+    if (0 != max_attempts && attempts + 1 >= max_attempts) return false;
+
+    if (attempts < UINT8_MAX) attempts++;
+    Enter(state);
+    return true;
+}
+
+uint32_t StateMachine::Residence(uint8_t s)
+{
+    if (s >= num_states) return 0;
+
+    // include the time spent so far in the current state
+    return (s == state) ? residence_ms[s] + (millis() - entered_ms) : residence_ms[s];
+}
+
+void StateMachine::Enter(uint8_t next_state)
+{
+    uint32_t now_ms = millis();
+
+    if (next_state >= num_states) next_state = 0;
+
+    // the first entry has no previous state to account for
+    if (0 != transitions) residence_ms[state] += now_ms - entered_ms;
+    entries[next_state]++;
+    transitions++;
+
+    state = next_state;
+    entered_ms = now_ms;
+    entry_pending = true;
+}
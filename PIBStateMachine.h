@@ -0,0 +1,111 @@
+/*
+ *  PIBStateMachine.h
+ *  Author:  Alex St. Clair
+ *  Created: October 2026
+ *
+ *  This file declares the table-driven engine behind the Flight_* state
+ *  machines. Each sequence declares a const table of its states, giving
+ *  the successor of each state and the resend action flag that times its
+ *  acknowledgement, and keeps a file-static PIBStateMachine sized for that
+ *  table. The retry policy for each resend action (timeouts, backoff, and
+ *  number of attempts) is kept in one place, in PIBRetry.
+ *
+ *  A state's entry actions (sending a command, arming its resend timer)
+ *  go under Entered(), which is true on the first loop after every
+ *  transition and after every retry. The StratoPIB helpers (AwaitAck and
+ *  friends) apply the retry policy and cancel the resend timer on an ack.
+ *  A state can also be left by an error or abort path, or abandoned when
+ *  its Flight mode exits and the machine is later restarted, so the
+ *  engine calls an exit hook with the old state's resend action on every
+ *  transition out of it, and StratoPIB cancels that action's timer.
+ *
+ *  The engine records time spent in and entries to each state, and the
+ *  total number of transitions, at the cost of one millis() call per
+ *  transition.
+ */
+
+#ifndef PIBSTATEMACHINE_H
+#define PIBSTATEMACHINE_H
+
+#include "Arduino.h"
+
+// declarative description of one state
+struct SMState_t {
+    uint8_t next;               // successor when the state completes normally
+    uint8_t resend_action;      // action flag used as the resend timer, NO_ACTION if none
+    const char * fail_msg;      // Zephyr warning when attempts are exhausted, NULL for none
+};
+
+// called with the resend action of each state left, the owner cancels its timer
+typedef void (*SMExitHook_t)(void * owner, uint8_t resend_action);
+
+enum SMResult_t : uint8_t {
+    SM_WAITING,
+    SM_DONE,
+    SM_RETRY,
+    SM_FAILED,
+};
+
+class StateMachine {
+public:
+    // set the exit hook shared by every state machine
+    static void SetExitHook(SMExitHook_t hook, void * owner);
+
+    // enter the initial state, resetting the retry count and exiting any abandoned state
+    void Start(uint8_t initial);
+
+    // leave the current state for another, resetting the retry count and running the exit hook
+    void Transition(uint8_t next_state);
+
+    // leave the current state for its declared successor
+    void Next() { Transition(table[state].next); }
+
+    // true once after each transition or retry, guards a state's entry actions
+    bool Entered();
+
+    // count an attempt and re-enter the state, false once max_attempts (0 for unlimited) are exhausted
+    bool Retry(uint8_t max_attempts);
+
+    uint8_t State() { return state; }
+    uint8_t Attempts() { return attempts; }
+    const SMState_t & Def() { return table[state]; }
+
+    // metrics
+    uint32_t Residence(uint8_t s);
+    uint16_t Entries(uint8_t s) { return (s < num_states) ? entries[s] : 0; }
+    uint16_t Transitions() { return transitions; }
+
+protected:
+    StateMachine(const SMState_t * table, uint8_t num_states, uint32_t * residence_ms, uint16_t * entries);
+
+private:
+    void Enter(uint8_t next_state);
+
+    static SMExitHook_t exit_hook;
+    static void * exit_owner;
+
+    const SMState_t * table;
+    uint8_t num_states;
+    uint32_t * residence_ms;
+    uint16_t * entries;
+
+    uint8_t state = 0;
+    uint8_t attempts = 0;
+    bool entry_pending = true;
+    uint32_t entered_ms = 0;
+    uint16_t transitions = 0;
+};
+
+// sized for a particular state table, keeps the per-state metrics
+template <uint8_t NUM_STATES>
+class PIBStateMachine : public StateMachine {
+public:
+    PIBStateMachine(const SMState_t (&table)[NUM_STATES])
+        : StateMachine(table, NUM_STATES, state_residence, state_entries) { }
+
+private:
+    uint32_t state_residence[NUM_STATES] = {0};
+    uint16_t state_entries[NUM_STATES] = {0};
+};
+
+#endif /* PIBSTATEMACHINE_H */
@@ -0,0 +1,198 @@
+/*
+ *  PIBTimers.cpp
+ *  Author:  Alex St. Clair
+ *  Created: October 2026
+ *
+ *  This class implements a hierarchical timer wheel for the PIB's
+ *  one-shot timeouts
+ */
+
+#include "PIBTimers.h"
+
+PIBTimers::PIBTimers()
+{
+    for (uint16_t i = 0; i < NUM_LISTS; i++) {
+        heads[i] = TIMER_NIL;
+    }
+
+    for (uint8_t i = 0; i < TIMER_POOL_SIZE; i++) {
+        nodes[i].generation = 0;
+        Link(i, FREE_LIST);
+    }
+}
+
+TimerHandle_t PIBTimers::Schedule(uint8_t action, uint32_t seconds)
+{
+    TimerHandle_t handle = {TIMER_NIL, 0};
+    uint8_t index = heads[FREE_LIST];
+
+    if (TIMER_NIL == index) {
+        stats.pool_exhausted++;
+        return handle;
+    }
+
+    if (seconds > TIMER_MAX_SECONDS) seconds = TIMER_MAX_SECONDS;
+
+    Unlink(index);
+    nodes[index].action = action;
+    nodes[index].expiry = current + seconds;
+    Insert(index);
+
+    stats.scheduled++;
+    if (++stats.active > stats.peak_active) stats.peak_active = stats.active;
+
+    handle.index = index;
+    handle.generation = nodes[index].generation;
+    return handle;
+}
+
+bool PIBTimers::Rearm(TimerHandle_t handle, uint32_t seconds)
+{
+    if (!Valid(handle)) return false;
+
+    if (seconds > TIMER_MAX_SECONDS) seconds = TIMER_MAX_SECONDS;
+
+    Unlink(handle.index);
+    nodes[handle.index].expiry = current + seconds;
+    Insert(handle.index);
+
+    stats.rearmed++;
+    return true;
+}
+
+bool PIBTimers::Cancel(TimerHandle_t handle)
+{
+    if (!Valid(handle)) return false;
+
+    Release(handle.index);
+
+    stats.cancelled++;
+    return true;
+}
+
+void PIBTimers::CancelAll()
+{
+    for (uint8_t i = 0; i < TIMER_POOL_SIZE; i++) {
+        if (FREE_LIST != nodes[i].list) {
+            Release(i);
+            stats.cancelled++;
+        }
+    }
+}
+
+bool PIBTimers::Active(TimerHandle_t handle)
+{
+    return Valid(handle) && EXPIRED_LIST != nodes[handle.index].list;
+}
+
+void PIBTimers::Advance(uint32_t now_seconds)
+{
+    // nothing to cascade or expire, so jump straight to the current time
+    if (0 == stats.active) {
+        current = now_seconds;
+        return;
+    }
+
+    while ((int32_t) (now_seconds - current) > 0) {
+        current++;
+
+        // at each wrap of a lower level, redistribute the next slot of the level above
+        if (0 == (current & TIMER_WHEEL_MASK)) {
+            if (0 == ((current >> TIMER_WHEEL_BITS) & TIMER_WHEEL_MASK)) {
+                Cascade(2 * TIMER_WHEEL_SLOTS + ((current >> (2 * TIMER_WHEEL_BITS)) & TIMER_WHEEL_MASK));
+            }
+            Cascade(TIMER_WHEEL_SLOTS + ((current >> TIMER_WHEEL_BITS) & TIMER_WHEEL_MASK));
+        }
+
+        // everything in the current level-0 slot expires now
+        uint8_t slot = current & TIMER_WHEEL_MASK;
+        while (TIMER_NIL != heads[slot]) {
+            uint8_t index = heads[slot];
+            Unlink(index);
+            Link(index, EXPIRED_LIST);
+        }
+    }
+}
+
+bool PIBTimers::PopExpired(uint8_t * action)
+{
+    uint8_t index = heads[EXPIRED_LIST];
+
+    if (TIMER_NIL == index) return false;
+
+    *action = nodes[index].action;
+    Release(index);
+
+    stats.fired++;
+    return true;
+}
+
+void PIBTimers::Link(uint8_t index, uint8_t list)
+{
+    nodes[index].list = list;
+    nodes[index].prev = TIMER_NIL;
+    nodes[index].next = heads[list];
+
+    if (TIMER_NIL != heads[list]) nodes[heads[list]].prev = index;
+    heads[list] = index;
+
+    if (list < EXPIRED_LIST) stats.level_active[list >> TIMER_WHEEL_BITS]++;
+}
+
+void PIBTimers::Unlink(uint8_t index)
+{
+    uint8_t list = nodes[index].list;
+    uint8_t prev = nodes[index].prev;
+    uint8_t next = nodes[index].next;
+
+    if (TIMER_NIL != prev) {
+        nodes[prev].next = next;
+    } else {
+        heads[list] = next;
+    }
+
+    if (TIMER_NIL != next) nodes[next].prev = prev;
+
+    if (list < EXPIRED_LIST) stats.level_active[list >> TIMER_WHEEL_BITS]--;
+}
+
+// place a node in the lowest level whose slots span its expiry
+void PIBTimers::Insert(uint8_t index)
+{
+    uint32_t expiry = nodes[index].expiry;
+
+    if ((int32_t) (expiry - current) <= 0) {
+        Link(index, EXPIRED_LIST);
+    } else if (expiry - current < TIMER_WHEEL_SLOTS) {
+        Link(index, expiry & TIMER_WHEEL_MASK);
+    } else if ((expiry >> TIMER_WHEEL_BITS) - (current >> TIMER_WHEEL_BITS) < TIMER_WHEEL_SLOTS) {
+        Link(index, TIMER_WHEEL_SLOTS + ((expiry >> TIMER_WHEEL_BITS) & TIMER_WHEEL_MASK));
+    } else {
+        Link(index, 2 * TIMER_WHEEL_SLOTS + ((expiry >> (2 * TIMER_WHEEL_BITS)) & TIMER_WHEEL_MASK));
+    }
+}
+
+void PIBTimers::Cascade(uint8_t list)
+{
+    while (TIMER_NIL != heads[list]) {
+        uint8_t index = heads[list];
+        Unlink(index);
+        Insert(index);
+    }
+}
+
+// return a node to the pool, invalidating any outstanding handles to it
+void PIBTimers::Release(uint8_t index)
+{
+    Unlink(index);
+    nodes[index].generation++;
+    Link(index, FREE_LIST);
+    stats.active--;
+}
+
+bool PIBTimers::Valid(TimerHandle_t handle)
+{
+    return handle.index < TIMER_POOL_SIZE
+           && handle.generation == nodes[handle.index].generation
+           && FREE_LIST != nodes[handle.index].list;
+}
@@ -0,0 +1,104 @@
+/*
+ *  PIBTimers.h
+ *  Author:  Alex St. Clair
+ *  Created: October 2026
+ *
+ *  This class implements a hierarchical timer wheel for the PIB's
+ *  one-shot timeouts (resends, motion timeouts, waits). Unlike the
+ *  StratoCore scheduler, every timer is returned as a handle that can
+ *  be cancelled or re-armed in O(1) without allocating a new entry.
+ *
+ *  The wheel has three levels of 64 one-second slots, covering up to
+ *  TIMER_MAX_SECONDS. Timers are linked into slots by index from a fixed
+ *  pool, and a handle carries a generation count so a stale handle to a
+ *  timer that has already fired or been cancelled is rejected.
+ */
+
+#ifndef PIBTIMERS_H
+#define PIBTIMERS_H
+
+#include "Arduino.h"
+
+#define TIMER_WHEEL_BITS    6
+#define TIMER_WHEEL_SLOTS   (1 << TIMER_WHEEL_BITS)
+#define TIMER_WHEEL_MASK    (TIMER_WHEEL_SLOTS - 1)
+#define TIMER_WHEEL_LEVELS  3
+
+// longest timer that can be scheduled, longer requests are clamped (~3 days)
+#define TIMER_MAX_SECONDS   (63UL << (2 * TIMER_WHEEL_BITS))
+
+// must be at least the number of actions that can be armed at once
+#define TIMER_POOL_SIZE     48
+
+#define TIMER_NIL           0xFF
+
+struct TimerHandle_t {
+    uint8_t index;
+    uint8_t generation;
+};
+
+struct TimerStats_t {
+    uint8_t active;                         // armed or expired but not yet collected
+    uint8_t peak_active;
+    uint8_t level_active[TIMER_WHEEL_LEVELS];
+    uint16_t scheduled;
+    uint16_t rearmed;
+    uint16_t cancelled;
+    uint16_t fired;
+    uint16_t pool_exhausted;
+};
+
+class PIBTimers {
+public:
+    PIBTimers();
+
+    // arm a new timer for an action, returns a handle with index TIMER_NIL if the pool is empty
+    TimerHandle_t Schedule(uint8_t action, uint32_t seconds);
+
+    // move an armed timer to a new expiry, false if the handle is stale
+    bool Rearm(TimerHandle_t handle, uint32_t seconds);
+
+    // disarm a timer (including one that has expired but not been collected)
+    bool Cancel(TimerHandle_t handle);
+    void CancelAll();
+
+    bool Active(TimerHandle_t handle);
+
+    // advance the wheel to the current time in seconds, call once per loop
+    void Advance(uint32_t now_seconds);
+
+    // collect one expired timer, returns false when none remain
+    bool PopExpired(uint8_t * action);
+
+    const TimerStats_t & Stats() { return stats; }
+
+private:
+    struct TimerNode_t {
+        uint32_t expiry;
+        uint8_t action;
+        uint8_t generation;
+        uint8_t prev;
+        uint8_t next;
+        uint8_t list;
+    };
+
+    // list indices: the wheel slots, then the expired list, then the free list
+    static const uint8_t EXPIRED_LIST = TIMER_WHEEL_LEVELS * TIMER_WHEEL_SLOTS;
+    static const uint8_t FREE_LIST = EXPIRED_LIST + 1;
+    static const uint16_t NUM_LISTS = FREE_LIST + 1;
+
+    void Link(uint8_t index, uint8_t list);
+    void Unlink(uint8_t index);
+    void Insert(uint8_t index);
+    void Cascade(uint8_t list);
+    void Release(uint8_t index);
+    bool Valid(TimerHandle_t handle);
+
+    TimerNode_t nodes[TIMER_POOL_SIZE];
+    uint8_t heads[NUM_LISTS];
+    uint32_t current = 0;
+
+    TimerStats_t stats = {0};
+};
+
+#endif /* PIBTIMERS_H */
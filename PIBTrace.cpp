@@ -0,0 +1,78 @@
+/*
+ *  PIBTrace.cpp
+ *  Author:  Alex St. Clair
+ *  Created: October 2026
+ *
+ *  This class is a tokenized debug logger for hot paths
+ */
+
+#include "PIBTrace.h"
+
+PIBTrace::PIBTrace(Stream * port)
+    : port(port)
+{
+}
+
+void PIBTrace::Log(uint8_t token, uint32_t a0, uint32_t a1, uint32_t a2,
+                   uint32_t a3, uint32_t a4, uint32_t a5)
+{
+    if (TRACE_SIZE == count) {
+        dropped++;
+        return;
+    }
+
+    TraceRecord_t & record = records[(head + count) % TRACE_SIZE];
+    record.ms = millis();
+    record.token = token;
+    record.args[0] = a0;
+    record.args[1] = a1;
+    record.args[2] = a2;
+    record.args[3] = a3;
+    record.args[4] = a4;
+    record.args[5] = a5;
+    count++;
+}
+
+void PIBTrace::Drain(uint8_t max_records)
+{
+    if (0 != dropped) {
+        if (!WriteLine(millis(), TR_DROPPED, &dropped, 1)) return;
+        dropped = 0;
+    }
+
+    while (0 != count && 0 != max_records--) {
+        const TraceRecord_t & record = records[head];
+
+        uint8_t num_args = TRACE_MAX_ARGS;
+        while (0 != num_args && 0 == record.args[num_args - 1]) num_args--;
+
+        if (!WriteLine(record.ms, record.token, record.args, num_args)) return;
+
+        head = (head + 1) % TRACE_SIZE;
+        count--;
+    }
+}
+
+uint32_t PIBTrace::Float(float value)
+{
+    uint32_t bits = 0;
+    memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+bool PIBTrace::WriteLine(uint32_t ms, uint8_t token, const uint32_t * args, uint8_t num_args)
+{
+    char line[TRACE_LINE_SIZE];
+
+    if (port->availableForWrite() < TRACE_LINE_SIZE) return false;
+
+    int length = snprintf(line, TRACE_LINE_SIZE, "TR %lx %x", (unsigned long) ms, token);
+    for (uint8_t i = 0; i < num_args && length < TRACE_LINE_SIZE; i++) {
+        length += snprintf(line + length, TRACE_LINE_SIZE - length, " %lx", (unsigned long) args[i]);
+    }
+    if (length > TRACE_LINE_SIZE - 2) length = TRACE_LINE_SIZE - 2;
+    line[length++] = '\n';
+
+    port->write((const uint8_t *) line, length);
+    return true;
+}
@@ -0,0 +1,67 @@
+/*
+ *  PIBTrace.h
+ *  Author:  Alex St. Clair
+ *  Created: October 2026
+ *
+ *  This class is a tokenized debug logger for hot paths. A log call
+ *  stores a token, the time, and up to six raw 32-bit arguments in a
+ *  ring buffer, with no formatting. The buffer drains to the debug port
+ *  a few records per loop, only while the port can take a line without
+ *  blocking, as lines of the form:
+ *
+ *    TR <millis> <token> <arg0> ... <argN>     (all hex, trailing zero args dropped)
+ *
+ *  The format for each token lives in tools/decode_trace.py, which turns
+ *  captured debug output back into text. Keep the two in sync.
+ */
+
+#ifndef PIBTRACE_H
+#define PIBTRACE_H
+
+#include "Arduino.h"
+
+#define TRACE_SIZE          64  // records
+#define TRACE_MAX_ARGS      6
+#define TRACE_LINE_SIZE     80
+#define TRACE_DRAIN_RECORDS 4   // per loop
+
+// tokens are append-only, the decoder relies on their values
+enum TraceToken_t : uint8_t {
+    TR_DROPPED = 0,     // records dropped while the buffer was full
+    TR_REEL_POSITION,   // position (revs, int32)
+    TR_TSEN_TM,         // PU time, v_battery, i_charge, therm1, therm2 (floats), heater_stat
+    TR_PROFILE_TM,      // profile_id << 16 | packet << 8 | heater_stat, PU time, v_battery, i_charge, therm1, therm2 (floats)
+    TR_LORA_PACKET,     // rssi (int32), bytes, first eight bytes (two u32, big-endian)
+    TR_LORA_TM_INDEX,   // LoRa TM buffer index
+};
+
+struct TraceRecord_t {
+    uint32_t ms;
+    uint8_t token;
+    uint32_t args[TRACE_MAX_ARGS];
+};
+
+class PIBTrace {
+public:
+    PIBTrace(Stream * port);
+
+    void Log(uint8_t token, uint32_t a0 = 0, uint32_t a1 = 0, uint32_t a2 = 0,
+             uint32_t a3 = 0, uint32_t a4 = 0, uint32_t a5 = 0);
+
+    // write up to max_records lines, stopping if the port would block
+    void Drain(uint8_t max_records);
+
+    // raw bits of a float argument
+    static uint32_t Float(float value);
+
+private:
+    bool WriteLine(uint32_t ms, uint8_t token, const uint32_t * args, uint8_t num_args);
+
+    Stream * port;
+    TraceRecord_t records[TRACE_SIZE];
+    uint8_t head = 0;   // next to drain
+    uint8_t count = 0;
+    uint32_t dropped = 0;
+};
+
+#endif /* PIBTRACE_H */
@@ -0,0 +1,120 @@
+/*
+ *  PIBZephyrLog.cpp
+ *  Author:  Alex St. Clair
+ *  Created: October 2026
+ *
+ *  This class coalesces repeated Zephyr log messages
+ */
+
+#include "PIBZephyrLog.h"
+
+// FNV-1a, to skip most string comparisons
+static uint32_t HashText(const char * text)
+{
+    uint32_t hash = 2166136261UL;
+
+    while ('\0' != *text) {
+        hash ^= (uint8_t) *text++;
+        hash *= 16777619UL;
+    }
+
+    return hash;
+}
+
+PIBZephyrLog::PIBZephyrLog()
+{
+    for (uint8_t i = 0; i < LOG_SLOTS; i++) {
+        slots[i].used = false;
+    }
+}
+
+bool PIBZephyrLog::Admit(uint8_t level, const char * text, uint32_t now_s, uint16_t window)
+{
+    if (0 == window) return true;
+
+    uint32_t hash = HashText(text);
+    LogSlot_t * slot = NULL;
+
+    for (uint8_t i = 0; i < LOG_SLOTS; i++) {
+        if (slots[i].used && slots[i].hash == hash && slots[i].level == level &&
+            0 == strncmp(slots[i].text, text, LOG_ARRAY_SIZE)) {
+            slot = &slots[i];
+            break;
+        }
+    }
+
+    // a repeat inside the window is only counted
+    if (NULL != slot && now_s - slot->opened < window) {
+        if (0 == slot->repeats) slot->first = now_s;
+        if (slot->repeats < UINT16_MAX) slot->repeats++;
+        slot->last = now_s;
+        folded++;
+        return false;
+    }
+
+    // otherwise reuse the message's slot, a free one, or evict the oldest that can be closed
+    if (NULL == slot) {
+        for (uint8_t i = 0; i < LOG_SLOTS; i++) {
+            if (!slots[i].used) {
+                slot = &slots[i];
+                break;
+            }
+
+            if (CanClose(slots[i]) && (NULL == slot || slots[i].opened < slot->opened)) slot = &slots[i];
+        }
+    }
+
+    // every summary is still pending, send this copy untracked rather than lose a count
+    if (NULL == slot || (slot->used && !CanClose(*slot))) return true;
+
+    if (slot->used) Close(*slot);
+
+    slot->used = true;
+    slot->level = level;
+    slot->hash = hash;
+    slot->repeats = 0;
+    slot->opened = now_s;
+    strncpy(slot->text, text, LOG_ARRAY_SIZE - 1);
+    slot->text[LOG_ARRAY_SIZE - 1] = '\0';
+
+    return true;
+}
+
+bool PIBZephyrLog::NextSummary(char * buffer, uint16_t size, uint8_t * level, uint32_t now_s, uint16_t window)
+{
+    LogSlot_t closed;
+
+    closed.used = false;
+
+    if (0 != num_held) {
+        closed = held[0];
+        num_held--;
+        for (uint8_t i = 0; i < num_held; i++) {
+            held[i] = held[i + 1];
+        }
+    } else {
+        for (uint8_t i = 0; i < LOG_SLOTS; i++) {
+            if (!slots[i].used || now_s - slots[i].opened < window) continue;
+
+            if (0 != slots[i].repeats) closed = slots[i];
+            slots[i].used = false;
+            if (closed.used) break;
+        }
+    }
+
+    if (!closed.used) return false;
+
+    snprintf(buffer, size, "x%u %lu-%lu: %s", closed.repeats, (unsigned long) closed.first,
+             (unsigned long) closed.last, closed.text);
+    *level = closed.level;
+
+    return true;
+}
+
+// hold a slot's summary until NextSummary, callers check CanClose first
+void PIBZephyrLog::Close(LogSlot_t & slot)
+{
+    if (0 != slot.repeats && num_held < LOG_HELD) held[num_held++] = slot;
+
+    slot.used = false;
+}
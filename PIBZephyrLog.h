@@ -0,0 +1,62 @@
+/*
+ *  PIBZephyrLog.h
+ *  Author:  Alex St. Clair
+ *  Created: October 2026
+ *
+ *  This class coalesces repeated Zephyr log messages. The first copy of
+ *  a message is sent as usual, and identical messages (same level and
+ *  text) within the window after it are only counted. When the window
+ *  closes, one summary carries the repeat count and the times of the
+ *  first and last repeat. A few recent messages are tracked at once; the
+ *  oldest is closed early if a new message needs its slot, and its
+ *  summary is held until it can be sent. A slot with repeats is never
+ *  closed while the held summaries are full: the new message is then sent
+ *  without being tracked, so no repeat count is ever lost.
+ */
+
+#ifndef PIBZEPHYRLOG_H
+#define PIBZEPHYRLOG_H
+
+#include "Arduino.h"
+#include "StratoCore.h"
+
+#define LOG_SLOTS   4
+#define LOG_HELD    4   // summaries of closed slots waiting to be sent
+
+struct LogSlot_t {
+    bool used;
+    uint8_t level;      // StateFlag_t
+    uint32_t hash;
+    uint16_t repeats;
+    uint32_t opened;    // seconds, when the first copy was sent
+    uint32_t first;     // seconds, first and last repeat
+    uint32_t last;
+    char text[LOG_ARRAY_SIZE];
+};
+
+class PIBZephyrLog {
+public:
+    PIBZephyrLog();
+
+    // true if the message should be sent now, false if it was folded into an earlier copy
+    bool Admit(uint8_t level, const char * text, uint32_t now_s, uint16_t window);
+
+    // fills a summary for a closed message with repeats, returns false when there are none
+    bool NextSummary(char * buffer, uint16_t size, uint8_t * level, uint32_t now_s, uint16_t window);
+
+    uint32_t Folded() { return folded; }
+
+private:
+    bool CanClose(const LogSlot_t & slot) { return 0 == slot.repeats || num_held < LOG_HELD; }
+    void Close(LogSlot_t & slot);
+
+    LogSlot_t slots[LOG_SLOTS];
+
+    // slots closed early with repeats, oldest first, waiting for their summaries to be sent
+    LogSlot_t held[LOG_HELD];
+    uint8_t num_held = 0;
+
+    uint32_t folded = 0;
+};
+
+#endif /* PIBZEPHYRLOG_H */
@@ -8,127 +8,119 @@
 
 #include "StratoPIB.h"
 
+// one route per PU message the PIB handles
+const MessageRoute_t StratoPIB::pu_routes[] = {
+    // type         id                  handler                              log only
+    {ASCII_MESSAGE,  PU_STATUS,          &StratoPIB::HandlePUStatus,          NULL},
+    {ASCII_MESSAGE,  PU_NO_MORE_RECORDS, &StratoPIB::HandlePUNoMoreRecords,   NULL},
+    {ACK_MESSAGE,    PU_GO_WARMUP,       &StratoPIB::HandlePUWarmupAck,       NULL},
+    {ACK_MESSAGE,    PU_GO_PROFILE,      &StratoPIB::HandlePUProfileAck,      NULL},
+    {ACK_MESSAGE,    PU_GO_PREPROFILE,   &StratoPIB::HandlePUPreprofileAck,   NULL},
+    {ACK_MESSAGE,    PU_RESET,           NULL,                                "PU acked reset"},
+    {BIN_MESSAGE,    PU_TSEN_RECORD,     &StratoPIB::HandlePUTSENRecord,      NULL},
+    {BIN_MESSAGE,    PU_PROFILE_RECORD,  &StratoPIB::HandlePUProfileRecord,   NULL},
+    {STRING_MESSAGE, PU_ERROR,           &StratoPIB::HandlePUError,           NULL},
+};
+
+const uint8_t StratoPIB::num_pu_routes = sizeof(pu_routes) / sizeof(pu_routes[0]);
+RouteStats_t StratoPIB::pu_route_stats[sizeof(pu_routes) / sizeof(pu_routes[0])] = {{0}};
+
 void StratoPIB::RunPURouter()
 {
     SerialMessage_t rx_msg = puComm.RX();
 
     while (NO_MESSAGE != rx_msg) {
         PUDock();
-        if (ASCII_MESSAGE == rx_msg) {
-            HandlePUASCII();
-        } else if (ACK_MESSAGE == rx_msg) {
-            HandlePUAck();
-        } else if (BIN_MESSAGE == rx_msg) {
-            HandlePUBin();
-        } else if (STRING_MESSAGE == rx_msg) {
-            HandlePUString();
-        } else {
-            log_error("Unknown message type from PU");
-        }
-
+        DispatchMessage(puComm, rx_msg, LINK_PU, pu_routes, pu_route_stats, num_pu_routes);
         rx_msg = puComm.RX();
     }
 }
 
-void StratoPIB::HandlePUASCII()
+void StratoPIB::HandlePUStatus()
+{
+    if (!puComm.ascii_rx.checksum_valid || !puComm.RX_Status(&pu_status.time, &pu_status.v_battery, &pu_status.i_charge, &pu_status.therm1, &pu_status.therm2, &pu_status.heater_stat)) {
+        pu_status.time = 0;
+        pu_status.v_battery = 0.0f;
+        pu_status.i_charge = 0.0f;
+        pu_status.therm1 = 0.0f;
+        pu_status.therm2 = 0.0f;
+        pu_status.heater_stat = 0;
+    } else {
+        latency.Received(ResendClass(RESEND_PU_CHECK));
+        pu_status.last_status = now();
+    }
+}
+
+void StratoPIB::HandlePUNoMoreRecords()
+{
+    latency.Received(ResendClass(RESEND_PU_RECORD));
+    pu_no_more_records = true;
+}
+
+void StratoPIB::HandlePUWarmupAck()
+{
+    log_nominal("PU in warmup");
+    latency.Received(ResendClass(RESEND_PU_WARMUP));
+    pu_warmup = true;
+}
+
+void StratoPIB::HandlePUProfileAck()
+{
+    log_nominal("PU in profile");
+    latency.Received(ResendClass(RESEND_PU_GOPROFILE));
+    pu_profile = true;
+}
+
+void StratoPIB::HandlePUPreprofileAck()
 {
-    switch (puComm.ascii_rx.msg_id) {
-    case PU_STATUS:
-        if (!puComm.ascii_rx.checksum_valid || !puComm.RX_Status(&pu_status.time, &pu_status.v_battery, &pu_status.i_charge, &pu_status.therm1, &pu_status.therm2, &pu_status.heater_stat)) {
-            pu_status.time = 0;
-            pu_status.v_battery = 0.0f;
-            pu_status.i_charge = 0.0f;
-            pu_status.therm1 = 0.0f;
-            pu_status.therm2 = 0.0f;
-            pu_status.heater_stat = 0;
-        } else {
-            pu_status.last_status = now();
-        }
-        break;
-    case PU_NO_MORE_RECORDS:
-        pu_no_more_records = true;
-        break;
-    default:
-        log_error("Unknown PU ASCII message received");
-        break;
+    log_nominal("PU in preprofile");
+    latency.Received(ResendClass(RESEND_PU_GOPROFILE));
+    pu_preprofile = true;
+}
+
+// can handle all PU TM receipt here with ACKs/NAKs and tm_finished + buffer_ready flags
+void StratoPIB::HandlePUTSENRecord()
+{
+    latency.Received(ResendClass(RESEND_PU_TSEN));
+    if (AcceptPURecord()) {
+        tsen_received = true;
+    } else {
+        log_error("TSEN checksum invalid or error adding to TM buffer");
     }
 }
 
-void StratoPIB::HandlePUAck()
+void StratoPIB::HandlePUProfileRecord()
 {
-    switch (puComm.ack_id) {
-    case PU_GO_WARMUP:
-        log_nominal("PU in warmup");
-        pu_warmup = true;
-        break;
-    case PU_GO_PROFILE:
-        log_nominal("PU in profile");
-        pu_profile = true;
-        break;
-    case PU_GO_PREPROFILE:
-        log_nominal("PU in preprofile");
-        pu_preprofile = true;
-        break;
-    case PU_RESET:
-        ZephyrLogFine("PU acked reset");
-        break;
-    default:
-        log_error("Unknown PU ack received");
-        break;
+    latency.Received(ResendClass(RESEND_PU_RECORD));
+    if (AcceptPURecord()) {
+        record_received = true;
+    } else {
+        log_error("Profile record checksum invalid or error adding to TM buffer");
     }
 }
 
-void StratoPIB::HandlePUBin()
+// place a PU record in the TM buffer, and ACK or NAK it to the PU
+bool StratoPIB::AcceptPURecord()
 {
-    // can handle all PU TM receipt here with ACKs/NAKs and tm_finished + buffer_ready flags
-    switch (puComm.binary_rx.bin_id) {
-    case PU_TSEN_RECORD:
-        // prep the TM buffer
-        zephyrTX.clearTm();
-
-        // see if we can place in the buffer
-        if (puComm.binary_rx.checksum_valid && zephyrTX.addTm(puComm.binary_rx.bin_buffer, puComm.binary_rx.bin_length)) {
-            tsen_received = true;
-            puComm.TX_Ack(PU_TSEN_RECORD, true);
-        } else {
-            log_error("TSEN checksum invalid or error adding to TM buffer");
-            puComm.TX_Ack(PU_TSEN_RECORD, false);
-            zephyrTX.clearTm();
-        }
-        break;
-
-    case PU_PROFILE_RECORD:
-        // prep the TM buffer
-        zephyrTX.clearTm();
-
-        // see if we can place in the buffer
-        if (puComm.binary_rx.checksum_valid && zephyrTX.addTm(puComm.binary_rx.bin_buffer, puComm.binary_rx.bin_length)) {
-            record_received = true;
-            puComm.TX_Ack(PU_TSEN_RECORD, true);
-        } else {
-            log_error("Profile record checksum invalid or error adding to TM buffer");
-            puComm.TX_Ack(PU_TSEN_RECORD, false);
-            zephyrTX.clearTm();
-        }
-        break;
-
-    default:
-        log_error("Unknown PU bin received");
-        break;
+    // prep the TM buffer
+    zephyrTX.clearTm();
+
+    // see if we can place in the buffer
+    if (puComm.binary_rx.checksum_valid && zephyrTX.addTm(puComm.binary_rx.bin_buffer, puComm.binary_rx.bin_length)) {
+        puComm.TX_Ack(PU_TSEN_RECORD, true);
+        return true;
     }
+
+    puComm.TX_Ack(PU_TSEN_RECORD, false);
+    link_stats[LINK_PU].naks++;
+    zephyrTX.clearTm();
+    return false;
 }
 
-void StratoPIB::HandlePUString()
+void StratoPIB::HandlePUError()
 {
-    switch (puComm.string_rx.str_id) {
-    case PU_ERROR:
-        if (puComm.RX_Error(log_array, LOG_ARRAY_SIZE)) {
-            ZephyrLogCrit(log_array);
-            inst_substate = MODE_ERROR;
-        }
-        break;
-    default:
-        log_error("Unknown PU String message received");
-        break;
+    if (puComm.RX_Error(log_array, LOG_ARRAY_SIZE)) {
+        ZephyrLogCrit(log_array);
+        inst_substate = MODE_ERROR;
     }
-}
\ No newline at end of file
+}
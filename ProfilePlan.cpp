@@ -0,0 +1,158 @@
+/*
+ *  ProfilePlan.cpp
+ *  Author:  Alex St. Clair
+ *  Created: October 2026
+ *
+ *  This file builds the list of motions (legs) that make up a profile.
+ *  A normal profile is a deploy, a dwell, and a retract to just short of
+ *  the dock. In yo-yo mode, the PU cycles between the bottom of the
+ *  profile and yoyo_top for yoyo_casts casts before the final retract,
+ *  so one warmup, dock, and MCB power cycle covers several profiles.
+ *  The final retract can be broken into a stepped ascent, pausing at each
+ *  of the profile_stops for its own dwell.
+ *
+ *  Any motion crossing one of the velocity_bands is split at the band
+ *  edges, so the reel can run fast through uninteresting layers and slow
+ *  through the band.
+ */
+
+#include "StratoPIB.h"
+
+// velocity for a depth from the band containing it, 0 (the configured velocity) outside all bands
+static float BandVelocity(const VelocityBands_t & bands, float depth)
+{
+    for (uint8_t i = 0; i < bands.num_bands && i < MAX_VELOCITY_BANDS; i++) {
+        if (depth >= bands.bands[i].top && depth <= bands.bands[i].bottom) return bands.bands[i].velocity;
+    }
+
+    return 0.0f;
+}
+
+// append a motion between two depths, split wherever it crosses a band edge, and return the new leg count
+static uint8_t AddLeg(ProfileLeg_t * legs, uint8_t count, const VelocityBands_t & bands,
+                      MCBMotion_t motion, float from, float to, float velocity, uint16_t dwell)
+{
+    float dir = (to > from) ? 1.0f : -1.0f;
+    float start = from;
+    float end = from;
+
+    while (count < MAX_PROFILE_LEGS && end != to) {
+        // the nearest band edge ahead, or the end of the motion (always, if only one leg is left)
+        end = to;
+        for (uint8_t i = 0; i < bands.num_bands && i < MAX_VELOCITY_BANDS && count < MAX_PROFILE_LEGS - 1; i++) {
+            float edges[2] = {bands.bands[i].top, bands.bands[i].bottom};
+            for (uint8_t j = 0; j < 2; j++) {
+                if ((edges[j] - start) * dir > 0.0f && (end - edges[j]) * dir > 0.0f) end = edges[j];
+            }
+        }
+
+        // an explicit velocity (a stop's) takes precedence over the bands
+        legs[count++] = {motion, (end - start) * dir, (velocity > 0.0f) ? velocity : BandVelocity(bands, 0.5f * (start + end)),
+                         (end == to) ? dwell : (uint16_t) 0};
+        start = end;
+    }
+
+    return count;
+}
+
+// fills legs (MAX_PROFILE_LEGS long) and returns the number of legs
+uint8_t StratoPIB::BuildProfilePlan(ProfileLeg_t * legs)
+{
+    float profile_size = ProfileSize();
+    float dock_amount = pibConfigs.dock_amount.Read();
+    float yoyo_top = pibConfigs.yoyo_top.Read();
+    uint8_t casts = pibConfigs.yoyo_casts.Read();
+    ProfileStops_t stops = pibConfigs.profile_stops.Read();
+    VelocityBands_t bands = pibConfigs.velocity_bands.Read();
+    float depth = profile_size;
+    uint8_t count = 0;
+
+    // each pass through the bands can add one leg per edge, leave room for the deploy and final ascent
+    uint8_t leg_pieces = 1 + 2 * bands.num_bands;
+    uint8_t max_casts = (MAX_PROFILE_LEGS - 2 * leg_pieces - stops.num_stops) / (2 * leg_pieces);
+
+    // the top of a cast must be below the dock and above the bottom of the profile
+    if (yoyo_top < dock_amount || yoyo_top >= profile_size) casts = 0;
+    if (casts > max_casts) casts = max_casts;
+
+    count = AddLeg(legs, count, bands, MOTION_REEL_OUT, 0.0f, profile_size, 0.0f, pibConfigs.dwell_time.Read());
+
+    for (uint8_t i = 0; i < casts; i++) {
+        count = AddLeg(legs, count, bands, MOTION_YOYO_IN, profile_size, yoyo_top, 0.0f, 0);
+        count = AddLeg(legs, count, bands, MOTION_YOYO_OUT, yoyo_top, profile_size, 0.0f, 0);
+    }
+
+    // stops outside the profile (e.g. after a change to profile_size) are skipped
+    for (uint8_t i = 0; i < stops.num_stops && i < MAX_PROFILE_STOPS; i++) {
+        if (stops.stops[i].depth >= depth || stops.stops[i].depth <= dock_amount) continue;
+        count = AddLeg(legs, count, bands, MOTION_REEL_IN, depth, stops.stops[i].depth, stops.stops[i].velocity, stops.stops[i].dwell);
+        depth = stops.stops[i].depth;
+    }
+
+    count = AddLeg(legs, count, bands, MOTION_REEL_IN, depth, dock_amount, 0.0f, 0);
+
+    return count;
+}
+
+// insert a stop in depth order, false if the table is full
+bool StratoPIB::AddProfileStop(ProfileStop_t stop)
+{
+    ProfileStops_t stops = pibConfigs.profile_stops.Read();
+    int i = stops.num_stops;
+
+    if (MAX_PROFILE_STOPS <= stops.num_stops) return false;
+
+    while (i > 0 && stops.stops[i - 1].depth < stop.depth) {
+        stops.stops[i] = stops.stops[i - 1];
+        i--;
+    }
+
+    stops.stops[i] = stop;
+    stops.num_stops++;
+    return pibConfigs.profile_stops.Write(stops);
+}
+
+// add a band if it doesn't overlap another, false if it does or the table is full
+bool StratoPIB::AddVelocityBand(VelocityBand_t band)
+{
+    VelocityBands_t bands = pibConfigs.velocity_bands.Read();
+
+    if (MAX_VELOCITY_BANDS <= bands.num_bands) return false;
+
+    for (uint8_t i = 0; i < bands.num_bands; i++) {
+        if (band.top < bands.bands[i].bottom && band.bottom > bands.bands[i].top) return false;
+    }
+
+    bands.bands[bands.num_bands++] = band;
+    return pibConfigs.velocity_bands.Write(bands);
+}
+
+// modelled motion and dwell time of legs first through last - 1
+uint32_t StratoPIB::PlanSeconds(const ProfileLeg_t * legs, uint8_t first, uint8_t last)
+{
+    float seconds = 0.0f;
+
+    for (uint8_t i = first; i < last; i++) {
+        seconds += MotionSeconds(legs[i].motion, legs[i].length, legs[i].velocity) + legs[i].dwell;
+    }
+
+    return (uint32_t) seconds;
+}
+
+const char * StratoPIB::LegName(MCBMotion_t motion)
+{
+    switch (motion) {
+    case MOTION_REEL_OUT:
+        return "reel out";
+    case MOTION_REEL_IN:
+        return "reel in";
+    case MOTION_YOYO_OUT:
+        return "yo-yo out";
+    case MOTION_YOYO_IN:
+        return "yo-yo in";
+    case MOTION_DOCK:
+        return "dock";
+    default:
+        return "motion";
+    }
+}
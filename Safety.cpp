@@ -29,12 +29,24 @@ enum SAStates_t : uint8_t {
     SA_EXIT = MODE_EXIT
 };
 
+// sends of each command being resent, to back off its resends
+static uint8_t retract_attempts = 0;
+static uint8_t dock_attempts = 0;
+static uint8_t lp_attempts = 0;
+static uint8_t safety_attempts = 0;
+
 void StratoPIB::SafetyMode()
 {
+    uint32_t tx_start = 0;
+
     switch (inst_substate) {
     case SA_ENTRY:
         // perform setup
         log_nominal("Entering SA");
+        retract_attempts = 0;
+        dock_attempts = 0;
+        lp_attempts = 0;
+        safety_attempts = 0;
         inst_substate = SA_SEND_FULL_RETRACT;
         break;
 
@@ -42,12 +54,13 @@ void StratoPIB::SafetyMode()
         mcb_reeling_in = false;
         mcb_motion_ongoing = true;
         mcbComm.TX_ASCII(MCB_FULL_RETRACT);
-        scheduler.AddAction(RESEND_FULL_RETRACT, MCB_RESEND_TIMEOUT);
+        ScheduleResend(RESEND_FULL_RETRACT, retract_attempts);
         inst_substate = SA_VERIFY_FULL_RETRACT;
         break;
 
     case SA_VERIFY_FULL_RETRACT:
         if (mcb_reeling_in) {
+            ResendAcked(RESEND_FULL_RETRACT, retract_attempts);
             log_nominal("MCB performing full retract");
             inst_substate = SA_MONITOR_FULL_RETRACT;
         }
@@ -70,7 +83,7 @@ void StratoPIB::SafetyMode()
 
         if (StartMCBMotion()) {
             inst_substate = SA_VERIFY_DOCK;
-            scheduler.AddAction(RESEND_MOTION_COMMAND, MCB_RESEND_TIMEOUT);
+            ScheduleResend(RESEND_MOTION_COMMAND, dock_attempts);
         } else {
             ZephyrLogWarn("Motion start error");
             inst_substate = MODE_ERROR;
@@ -80,7 +93,8 @@ void StratoPIB::SafetyMode()
     case SA_VERIFY_DOCK:
         if (mcb_motion_ongoing) { // set in the Ack handler
             log_nominal("MCB commanded motion");
-            scheduler.AddAction(ACTION_MOTION_TIMEOUT, max_profile_seconds);
+            ResendAcked(RESEND_MOTION_COMMAND, dock_attempts);
+            ScheduleTimer(ACTION_MOTION_TIMEOUT, max_profile_seconds);
             inst_substate = SA_MONITOR_DOCK;
         }
 
@@ -98,18 +112,21 @@ void StratoPIB::SafetyMode()
     case SA_SEND_MCB_LP:
         mcb_low_power = false;
         mcbComm.TX_ASCII(MCB_GO_LOW_POWER);
-        scheduler.AddAction(RESEND_MCB_LP, MCB_RESEND_TIMEOUT);
+        ScheduleResend(RESEND_MCB_LP, lp_attempts);
         inst_substate = SA_VERIFY_MCB_LP;
         break;
 
     case SA_VERIFY_MCB_LP:
         if (mcb_low_power) {
+            ResendAcked(RESEND_MCB_LP, lp_attempts);
             log_nominal("MCB in low power for safety");
             inst_substate = SA_SEND_S;
         }
 
         if (CheckAction(RESEND_MCB_LP)) {
             mcbComm.TX_ASCII(MCB_GO_LOW_POWER);
+            retry.Retried(ResendClass(RESEND_MCB_LP));
+            CountResend(RESEND_MCB_LP);
             inst_substate = SA_SEND_S; // actually just skip to sending safety
         }
         break;
@@ -117,8 +134,10 @@ void StratoPIB::SafetyMode()
     case SA_SEND_S:
         log_nominal("Sending safety message");
         digitalWrite(SAFE_PIN, HIGH);
+        tx_start = zephyr_link.TXBytes();
         zephyrTX.S();
-        scheduler.AddAction(RESEND_SAFETY, ZEPHYR_RESEND_TIMEOUT);
+        CountZephyrTX(ZCAT_SAFETY, tx_start);
+        ScheduleResend(RESEND_SAFETY, safety_attempts);
         inst_substate = SA_ACK_WAIT;
         break;
 
@@ -128,10 +147,12 @@ void StratoPIB::SafetyMode()
         if (S_ack_flag == ACK) {
             // clear the ack flag and go to the loop
             S_ack_flag = NO_ACK;
+            ResendAcked(RESEND_SAFETY, safety_attempts);
             inst_substate = SA_LOOP;
         } else if (S_ack_flag == NAK) {
             // just clear the ack flag -- a resend is already scheduled
             S_ack_flag = NO_ACK;
+            link_stats[LINK_ZEPHYR].naks++;
         }
 
         // if a minute has passed, resend safety
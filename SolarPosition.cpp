@@ -0,0 +1,82 @@
+/*
+ *  SolarPosition.cpp
+ *  Author:  Alex St. Clair
+ *  Created: October 2026
+ *
+ *  This file implements a compact solar ephemeris, after the NOAA solar
+ *  calculator equations
+ */
+
+#include "SolarPosition.h"
+
+#define J2000_EPOCH         946728000UL // 2000-01-01 12:00 UTC
+#define SECONDS_PER_DAY     86400UL
+
+// coarse search step, then bisection to the final resolution (seconds)
+#define CROSSING_STEP       300
+#define CROSSING_RESOLUTION 10
+
+static float Radians(float degrees) { return degrees * (float) DEG_TO_RAD; }
+static float Degrees(float radians) { return radians * (float) RAD_TO_DEG; }
+
+float SolarZenith(uint32_t epoch, float latitude, float longitude)
+{
+    // Julian centuries since J2000, offset in integer seconds first to keep float precision
+    float t = ((int32_t) (epoch - J2000_EPOCH) / (float) SECONDS_PER_DAY) / 36525.0f;
+
+    float mean_long = fmodf(280.46646f + t * 36000.76983f, 360.0f);
+    float mean_anom = Radians(fmodf(357.52911f + t * 35999.05029f, 360.0f));
+    float eccent = 0.016708634f - t * 0.000042037f;
+
+    float center = sinf(mean_anom) * (1.914602f - t * 0.004817f) + sinf(2 * mean_anom) * (0.019993f - t * 0.000101f)
+                   + sinf(3 * mean_anom) * 0.000289f;
+    float omega = Radians(125.04f - t * 1934.136f);
+    float app_long = Radians(mean_long + center - 0.00569f - 0.00478f * sinf(omega));
+
+    float obliq = Radians(23.0f + (26.0f + (21.448f - t * 46.815f) / 60.0f) / 60.0f + 0.00256f * cosf(omega));
+    float decl = asinf(sinf(obliq) * sinf(app_long));
+
+    // equation of time in minutes
+    float y = tanf(obliq / 2) * tanf(obliq / 2);
+    float l0 = Radians(mean_long);
+    float eq_time = 4.0f * Degrees(y * sinf(2 * l0) - 2 * eccent * sinf(mean_anom) + 4 * eccent * y * sinf(mean_anom) * cosf(2 * l0)
+                                   - 0.5f * y * y * sinf(4 * l0) - 1.25f * eccent * eccent * sinf(2 * mean_anom));
+
+    float true_solar_time = fmodf((epoch % SECONDS_PER_DAY) / 60.0f + eq_time + 4.0f * longitude + 1440.0f, 1440.0f);
+    float hour_angle = Radians(true_solar_time / 4.0f - 180.0f);
+
+    float cos_zenith = sinf(Radians(latitude)) * sinf(decl) + cosf(Radians(latitude)) * cosf(decl) * cosf(hour_angle);
+    if (cos_zenith > 1.0f) cos_zenith = 1.0f;
+    if (cos_zenith < -1.0f) cos_zenith = -1.0f;
+
+    return Degrees(acosf(cos_zenith));
+}
+
+uint32_t PredictSZACrossing(uint32_t start, float latitude, float longitude, float sza, uint32_t horizon, bool rising)
+{
+    uint32_t before = start;
+    bool was_above = SolarZenith(start, latitude, longitude) >= sza;
+
+    for (uint32_t offset = CROSSING_STEP; offset <= horizon; offset += CROSSING_STEP) {
+        uint32_t after = start + offset;
+        bool above = SolarZenith(after, latitude, longitude) >= sza;
+
+        if (above != was_above && above == rising) {
+            // the crossing is bracketed, bisect it down to the resolution
+            while (after - before > CROSSING_RESOLUTION) {
+                uint32_t mid = before + (after - before) / 2;
+                if ((SolarZenith(mid, latitude, longitude) >= sza) == rising) {
+                    after = mid;
+                } else {
+                    before = mid;
+                }
+            }
+            return after;
+        }
+
+        before = after;
+        was_above = above;
+    }
+
+    return 0;
+}
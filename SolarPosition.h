@@ -0,0 +1,23 @@
+/*
+ *  SolarPosition.h
+ *  Author:  Alex St. Clair
+ *  Created: October 2026
+ *
+ *  This file declares a compact solar ephemeris, after the NOAA solar
+ *  calculator equations, used to predict when the solar zenith angle
+ *  will cross the profile trigger. Single precision gives accuracy of
+ *  a few hundredths of a degree over a flight.
+ */
+
+#ifndef SOLARPOSITION_H
+#define SOLARPOSITION_H
+
+#include "Arduino.h"
+
+// solar zenith angle in degrees at a UNIX time, latitude and longitude in degrees (north and east positive)
+float SolarZenith(uint32_t epoch, float latitude, float longitude);
+
+// first time within horizon seconds after start at which the zenith angle rises (or falls) through sza, 0 if none
+uint32_t PredictSZACrossing(uint32_t start, float latitude, float longitude, float sza, uint32_t horizon, bool rising = true);
+
+#endif /* SOLARPOSITION_H */
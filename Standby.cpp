@@ -26,7 +26,7 @@ void StratoPIB::StandbyMode()
         log_nominal("Entering SB");
 
         // send mode request in first loop
-        scheduler.AddAction(SEND_IMR, 0);
+        ScheduleTimer(SEND_IMR, 0);
 
         inst_substate = SB_LOOP;
         break;
@@ -38,7 +38,7 @@ void StratoPIB::StandbyMode()
         if (CheckAction(SEND_IMR)) {
             log_nominal("Sending mode request to OBC");
             zephyrTX.IMR();
-            scheduler.AddAction(SEND_IMR, 60);
+            ScheduleTimer(SEND_IMR, 60);
         }
         break;
     case SB_ERROR_LANDING:
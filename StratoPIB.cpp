@@ -19,11 +19,40 @@ void onReceive(int Size)
 
 #include "StratoPIB.h"
 
+// retry policy for each resend action, in ScheduleAction_t order
+// commands that start motion or change the PU mode keep their old fixed timeout as
+// a floor, since resending them while an ack is in flight would repeat the command
+static const RetryPolicy_t retry_policies[NUM_RESEND_CLASSES] = {
+    // peer       attempts  min timeout         timeout                max timeout
+    {PEER_ZEPHYR, 0,        RTT_MIN_TIMEOUT,    ZEPHYR_RESEND_TIMEOUT, 300},  // RESEND_SAFETY
+    {PEER_MCB,    3,        RTT_MIN_TIMEOUT,    MCB_RESEND_TIMEOUT,    40},   // RESEND_MCB_LP
+    {PEER_ZEPHYR, 2,        RTT_MIN_TIMEOUT,    ZEPHYR_RESEND_TIMEOUT, 120},  // RESEND_RA
+    {PEER_MCB,    3,        MCB_RESEND_TIMEOUT, MCB_RESEND_TIMEOUT,    40},   // RESEND_MOTION_COMMAND
+    {PEER_ZEPHYR, 2,        RTT_MIN_TIMEOUT,    ZEPHYR_RESEND_TIMEOUT, 120},  // RESEND_TM
+    {PEER_PU,     3,        RTT_MIN_TIMEOUT,    PU_RESEND_TIMEOUT,     40},   // RESEND_PU_CHECK
+    {PEER_PU,     3,        RTT_MIN_TIMEOUT,    PU_RESEND_TIMEOUT,     40},   // RESEND_PU_TSEN
+    {PEER_PU,     3,        RTT_MIN_TIMEOUT,    PU_RESEND_TIMEOUT,     40},   // RESEND_PU_RECORD
+    {PEER_PU,     3,        PU_RESEND_TIMEOUT,  PU_RESEND_TIMEOUT,     40},   // RESEND_PU_WARMUP
+    {PEER_PU,     3,        PU_RESEND_TIMEOUT,  PU_RESEND_TIMEOUT,     40},   // RESEND_PU_GOPROFILE
+    {PEER_MCB,    0,        MCB_RESEND_TIMEOUT, MCB_RESEND_TIMEOUT,    60},   // RESEND_FULL_RETRACT
+};
+
 StratoPIB::StratoPIB()
-    : StratoCore(&ZEPHYR_SERIAL, INSTRUMENT, &DEBUG_SERIAL)
-    , mcbComm(&MCB_SERIAL)
-    , puComm(&PU_SERIAL)
+    : StratoCore(&zephyr_link, INSTRUMENT, &DEBUG_SERIAL) // StratoCore only stores the pointer
+    , zephyr_link(&ZEPHYR_SERIAL, &link_stats[LINK_ZEPHYR])
+    , mcb_link(&MCB_SERIAL, &link_stats[LINK_MCB])
+    , pu_link(&PU_SERIAL, &link_stats[LINK_PU])
+    , mcbComm(&mcb_link)
+    , puComm(&pu_link)
+    , retry(retry_policies, NUM_RESEND_CLASSES)
+    , trace(&DEBUG_SERIAL)
 {
+    for (int i = 0; i < NUM_ACTIONS; i++) {
+        action_timers[i].index = TIMER_NIL;
+        action_timers[i].generation = 0;
+    }
+
+    StateMachine::SetExitHook(ExitState, this);
 }
 
 // --------------------------------------------------------
@@ -49,15 +78,19 @@ void StratoPIB::InstrumentSetup()
 
     LoRa.setSPI(SPI1);
     LoRa.setPins(SS_PIN, RESET_PIN,INTERUPT_PIN);
-    
+
+    if (!pibConfigs.Initialize()) {
+        ZephyrLogWarn("Error loading from EEPROM! Reconfigured");
+    }
+
+    // the radio settings come from the configs, so start the modem once they're loaded
     LoRaInit();  //initialize the LoRa modem
+    lora_link.Reset(pibConfigs.lora_sf.Read(), now());
 
     LoRa.onReceive(onReceive);
     LoRa.receive();
 
-    if (!pibConfigs.Initialize()) {
-        ZephyrLogWarn("Error loading from EEPROM! Reconfigured");
-    }
+    retry.SetBudget(pibConfigs.retry_budget.Read());
 
     mcbComm.AssignBinaryRXBuffer(binary_mcb, MCB_BUFFER_SIZE);
     puComm.AssignBinaryRXBuffer(binary_pu, PU_BUFFER_SIZE);
@@ -66,8 +99,14 @@ void StratoPIB::InstrumentSetup()
 void StratoPIB::InstrumentLoop()
 {
     WatchFlags();
+    RunTimers();
     CheckTSEN();
+    CheckHousekeeping();
     LoRaRX();
+    CheckLoRaStatus();
+    CheckLoRaLink();
+    FlushZephyrLogs();
+    trace.Drain(TRACE_DRAIN_RECORDS);
 }
 
 void StratoPIB::LoRaInit()
@@ -76,12 +115,33 @@ void StratoPIB::LoRaInit()
        ZephyrLogWarn("Starting LoRa failed!");
        Serial.println("WARN: LoRa Initializtion Failed");
     }
+    LoRaApplyRadio();
+}
+
+void StratoPIB::LoRaApplyRadio()
+{
     delay(1);
-    LoRa.setSpreadingFactor(SF);
+    LoRa.setSpreadingFactor(pibConfigs.lora_sf.Read());
     delay(1);
-    LoRa.setSignalBandwidth(BANDWIDTH);
+    LoRa.setSignalBandwidth(pibConfigs.lora_bandwidth.Read());
     delay(1);
-    LoRa.setTxPower(RF_POWER);
+    LoRa.setTxPower(pibConfigs.lora_power.Read());
+}
+
+// while undocked, report each change in the recommended spreading factor (called in InstrumentLoop)
+void StratoPIB::CheckLoRaLink()
+{
+    if (pibConfigs.pu_docked.Read()) return;
+
+    // the PU sends status every lora_tx_status seconds, so allow for one missed packet
+    uint32_t contact_timeout = 2 * (uint32_t) pibConfigs.lora_tx_status.Read();
+    if (contact_timeout < LORA_TM_TIMEOUT) contact_timeout = LORA_TM_TIMEOUT;
+
+    if (!lora_link.Update(now(), pibConfigs.lora_margin.Read(), contact_timeout)) return;
+
+    snprintf(log_array, LOG_ARRAY_SIZE, "LoRa link: SNR %0.1f dB, RSSI %0.0f dBm, %u pkts, recommend SF%u (radio SF%u)",
+             lora_link.SNR(), lora_link.RSSI(), lora_link.Packets(), lora_link.Recommended(), pibConfigs.lora_sf.Read());
+    ZephyrLogFine(log_array);
 }
 
 void StratoPIB::LoRaRX()
@@ -91,28 +151,32 @@ void StratoPIB::LoRaRX()
     if (PacketSize > 0) //if LoRa data is available
     {
         PacketSize = 0;
-        Serial.print("Received Packet with RSSI :");
-        Serial.println(LoRa.packetRssi());
+        int rssi = LoRa.packetRssi();
+        float snr = LoRa.packetSnr();
+        lora_link.Packet(rssi, snr, now());
         int BytesToRead = LoRa.available();
-        Serial.printf("Bytes to Read: %d\n",BytesToRead);
+        link_stats[LINK_LORA].rx_msgs++;
+        link_stats[LINK_LORA].rx_bytes += BytesToRead;
         for (i = 0; i <  BytesToRead; i++)
            LoRa_RX_buffer[i] = LoRa.read();
-        
-        for (i = 0; i< BytesToRead; i++ ) //for debug write buffer to consols
-            Serial.write(LoRa_RX_buffer[i]);
-        Serial.println();
+
+        //for debug, trace the packet header instead of echoing every byte
+        uint8_t header[8] = {0};
+        memcpy(header, LoRa_RX_buffer, (BytesToRead < 8) ? BytesToRead : 8);
+        trace.Log(TR_LORA_PACKET, (uint32_t) rssi, BytesToRead,
+                  ((uint32_t) header[0] << 24) | ((uint32_t) header[1] << 16) | ((uint32_t) header[2] << 8) | header[3],
+                  ((uint32_t) header[4] << 24) | ((uint32_t) header[5] << 16) | ((uint32_t) header[6] << 8) | header[7]);
 
         if (strncmp(LoRa_RX_buffer,"ST",2) == 0)//it is a status packet
         { 
             LoRa_RX_buffer[BytesToRead] = '\0'; //null terminate buffer to make a string
-            ZephyrLogFine(LoRa_RX_buffer);
+            HandleLoRaStatus((const char *) LoRa_RX_buffer, rssi, snr);
 
         }
 
         else if (strncmp(LoRa_RX_buffer,"TM",2) == 0) //it is a profile TM packet
         {
-                Serial.print("TM Packet idx: ");
-                Serial.println(LoRa_TM_buffer_idx);
+                trace.Log(TR_LORA_TM_INDEX, LoRa_TM_buffer_idx);
                 LoRa_rx_time = millis();  //record the time we received last LoRa TM
                 if (LoRa_TM_buffer_idx + BytesToRead > 6005) //if the incomming packet will over fill a TM send what we have
                 {
@@ -123,7 +187,7 @@ void StratoPIB::LoRaRX()
                     zephyrTX.setStateFlagValue(1, FINE);
                     zephyrTX.setStateFlagValue(2, NOMESS);
                     zephyrTX.setStateFlagValue(3, NOMESS);
-                    zephyrTX.TM();
+                    SendZephyrTM(ZCAT_LORA_TM);
                     log_nominal(log_array);
                     LoRa_TM_buffer_idx = 0; //reset the buffer
                     zephyrTX.clearTm();
@@ -137,6 +201,7 @@ void StratoPIB::LoRaRX()
 
         else
         {
+            link_stats[LINK_LORA].unknown_ids++;
             snprintf(log_array, LOG_ARRAY_SIZE, "Received Unknown LoRa Packet");
             log_nominal(log_array);
         }
@@ -155,7 +220,7 @@ void StratoPIB::LoRaRX()
                     zephyrTX.setStateFlagValue(1, FINE);
                     zephyrTX.setStateFlagValue(2, NOMESS);
                     zephyrTX.setStateFlagValue(3, NOMESS);
-                    zephyrTX.TM();
+                    SendZephyrTM(ZCAT_LORA_TM);
                     log_nominal(log_array);
                     LoRa_TM_buffer_idx = 0; //reset the buffer
                     pu_tm_counter = 0; //reset the TM counter
@@ -164,20 +229,47 @@ void StratoPIB::LoRaRX()
 }
 
 // --------------------------------------------------------
-// Action handler and action flag helper functions
+// Zephyr log coalescing
 // --------------------------------------------------------
 
-void StratoPIB::ActionHandler(uint8_t action)
+void StratoPIB::ZephyrLogFine(const char * log_info)
 {
-    // for safety, ensure index doesn't exceed array size
-    if (action >= NUM_ACTIONS) {
-        log_error("Out of bounds action flag access");
-        return;
+    if (zephyrLog.Admit(FINE, log_info, now(), pibConfigs.log_window.Read())) StratoCore::ZephyrLogFine(log_info);
+}
+
+void StratoPIB::ZephyrLogWarn(const char * log_info)
+{
+    if (zephyrLog.Admit(WARN, log_info, now(), pibConfigs.log_window.Read())) StratoCore::ZephyrLogWarn(log_info);
+}
+
+// critical messages are never folded
+void StratoPIB::ZephyrLogCrit(const char * log_info)
+{
+    StratoCore::ZephyrLogCrit(log_info);
+}
+
+// send at most one summary per loop for messages whose window has closed
+void StratoPIB::FlushZephyrLogs()
+{
+    char summary[LOG_ARRAY_SIZE];
+    uint8_t level = FINE;
+
+    if (!zephyrLog.NextSummary(summary, LOG_ARRAY_SIZE, &level, now(), pibConfigs.log_window.Read())) return;
+
+    if (WARN == level) {
+        StratoCore::ZephyrLogWarn(summary);
+    } else {
+        StratoCore::ZephyrLogFine(summary);
     }
+}
+
+// --------------------------------------------------------
+// Action handler and action flag helper functions
+// --------------------------------------------------------
 
-    // set the flag and reset the stale count
-    action_flags[action].flag_value = true;
-    action_flags[action].stale_count = 0;
+void StratoPIB::ActionHandler(uint8_t action)
+{
+    SetAction(action);
 }
 
 bool StratoPIB::CheckAction(uint8_t action)
@@ -189,9 +281,15 @@ bool StratoPIB::CheckAction(uint8_t action)
     }
 
     // check and clear the flag if it is set, return the value
-    if (action_flags[action].flag_value) {
-        action_flags[action].flag_value = false;
-        action_flags[action].stale_count = 0;
+    if (pending_actions[action].pending) {
+        uint32_t latency = millis() - pending_actions[action].enqueue_ms;
+
+        pending_actions[action].pending = false;
+        work_stats.depth--;
+        work_stats.served++;
+        work_stats.total_latency_ms += latency;
+        if (latency > work_stats.max_latency_ms) work_stats.max_latency_ms = latency;
+
         return true;
     } else {
         return false;
@@ -200,53 +298,339 @@ bool StratoPIB::CheckAction(uint8_t action)
 
 void StratoPIB::SetAction(uint8_t action)
 {
-    action_flags[action].flag_value = true;
-    action_flags[action].stale_count = 0;
+    // for safety, ensure index doesn't exceed array size
+    if (action >= NUM_ACTIONS) {
+        log_error("Out of bounds action flag access");
+        return;
+    }
+
+    // a duplicate request folds into the pending one and keeps its enqueue time
+    if (pending_actions[action].pending) {
+        if (pending_actions[action].coalesced < UINT8_MAX) pending_actions[action].coalesced++;
+        work_stats.coalesced++;
+        return;
+    }
+
+    pending_actions[action].pending = true;
+    pending_actions[action].coalesced = 0;
+    pending_actions[action].enqueue_ms = millis();
+
+    if (++work_stats.depth > work_stats.peak_depth) work_stats.peak_depth = work_stats.depth;
+}
+
+void StratoPIB::DropAction(uint8_t action)
+{
+    if (action >= NUM_ACTIONS || !pending_actions[action].pending) return;
+
+    pending_actions[action].pending = false;
+    work_stats.depth--;
+}
+
+void StratoPIB::ClearActions()
+{
+    for (int i = 0; i < NUM_ACTIONS; i++) {
+        DropAction(i);
+    }
+}
+
+uint16_t StratoPIB::ActionTTL(uint8_t action)
+{
+    switch (action) {
+    // work requests are held until a mode is free to serve them
+    case EXIT_ERROR_STATE:
+    case ACTION_CHECK_PU:
+    case ACTION_OFFLOAD_PU:
+    case COMMAND_REDOCK:
+    case COMMAND_SEND_TSEN:
+    case COMMAND_MANUAL_PROFILE:
+    case COMMAND_DOCKED_PROFILE:
+    case COMMAND_RUN_SEQUENCE:
+    case ACTION_SEND_HK:
+    case ACTION_SEND_LORA_STATUS:
+        return 0;
+    // a scheduled profile may land while the previous profile or offload is finishing
+    case ACTION_BEGIN_PROFILE:
+        return ACTION_TTL_PROFILE;
+    // resends, timeouts, and motion commands are only meaningful right away
+    default:
+        return ACTION_TTL_DEFAULT;
+    }
 }
 
 void StratoPIB::WatchFlags()
 {
-    // monitor for and clear stale flags
+    // Zephyr acks are set by StratoCore, note their arrival for the RTT sample
+    if (NO_ACK != RA_ack_flag) latency.Received(ResendClass(RESEND_RA));
+    if (NO_ACK != TM_ack_flag) latency.Received(ResendClass(RESEND_TM));
+
+    // monitor for and expire pending actions that have outlived their TTL
     for (int i = 0; i < NUM_ACTIONS; i++) {
-        if (action_flags[i].flag_value) {
-            action_flags[i].stale_count++;
-            if (action_flags[i].stale_count >= FLAG_STALE) {
-                action_flags[i].flag_value = false;
-                action_flags[i].stale_count = 0;
+        if (pending_actions[i].pending) {
+            uint16_t ttl = ActionTTL(i);
+            if (0 != ttl && millis() - pending_actions[i].enqueue_ms >= 1000 * (uint32_t) ttl) {
+                DropAction(i);
+                work_stats.expired++;
             }
         }
     }
 }
 
+bool StratoPIB::ScheduleTimer(uint8_t action, uint32_t seconds)
+{
+    // for safety, ensure index doesn't exceed array size
+    if (action >= NUM_ACTIONS) {
+        log_error("Out of bounds action timer access");
+        return false;
+    }
+
+    // re-arm in place if this action's timer is still armed
+    if (timers.Rearm(action_timers[action], seconds)) return true;
+
+    action_timers[action] = timers.Schedule(action, seconds);
+
+    if (TIMER_NIL == action_timers[action].index) {
+        log_error("Timer pool exhausted");
+        return false;
+    }
+
+    return true;
+}
+
+void StratoPIB::CancelTimer(uint8_t action)
+{
+    // for safety, ensure index doesn't exceed array size
+    if (action >= NUM_ACTIONS) {
+        log_error("Out of bounds action timer access");
+        return;
+    }
+
+    timers.Cancel(action_timers[action]);
+    DropAction(action);
+}
+
+void StratoPIB::RunTimers()
+{
+    uint32_t elapsed = millis() - timer_millis;
+    uint8_t action = NO_ACTION;
+
+    // accumulate whole seconds so the wheel keeps counting through a millis() rollover
+    timer_seconds += elapsed / 1000;
+    timer_millis += 1000 * (elapsed / 1000);
+
+    timers.Advance(timer_seconds);
+
+    while (timers.PopExpired(&action)) {
+        ActionHandler(action);
+    }
+}
+
+// --------------------------------------------------------
+// State machine helpers
+// --------------------------------------------------------
+
+// each resend action is its own command class, RTT_NONE for other actions
+uint8_t StratoPIB::ResendClass(uint8_t resend_action)
+{
+    if (resend_action < RESEND_SAFETY || resend_action > RESEND_FULL_RETRACT) return RTT_NONE;
+
+    return resend_action - RESEND_SAFETY;
+}
+
+// the measured timeout (capped by the policy's), backed off for each attempt after the first
+uint16_t StratoPIB::ResendTimeout(uint8_t resend_action, uint8_t attempt)
+{
+    uint8_t resend_class = ResendClass(resend_action);
+
+    if (RTT_NONE == resend_class) return ZEPHYR_RESEND_TIMEOUT;
+
+    const RetryPolicy_t & policy = retry.Policy(resend_class);
+    uint16_t base = latency.Timeout(resend_class, policy.min_timeout, policy.timeout);
+    return retry.Backoff(resend_class, base, attempt);
+}
+
+// called just after a state sends its command
+// state machine exit hook, a resend timer never outlives its state
+void StratoPIB::ExitState(void * owner, uint8_t resend_action)
+{
+    if (NO_ACTION != resend_action) ((StratoPIB *) owner)->CancelTimer(resend_action);
+}
+
+void StratoPIB::ScheduleResend(uint8_t resend_action, uint8_t & attempts)
+{
+    if (0 != attempts) {
+        retry.Retried(ResendClass(resend_action));
+        CountResend(resend_action);
+    }
+
+    ScheduleTimer(resend_action, ResendTimeout(resend_action, attempts));
+    if (attempts < UINT8_MAX) attempts++;
+}
+
+void StratoPIB::ResendAcked(uint8_t resend_action, uint8_t & attempts)
+{
+    CancelTimer(resend_action);
+    retry.Succeeded(ResendClass(resend_action));
+    attempts = 0;
+}
+
+void StratoPIB::ArmResend(StateMachine & sm)
+{
+    const SMState_t & def = sm.Def();
+
+    latency.Sent(ResendClass(def.resend_action), 0 != sm.Attempts());
+    ScheduleTimer(def.resend_action, ResendTimeout(def.resend_action, sm.Attempts()));
+}
+
+// wait for a state's acknowledgement, resending per the action's retry policy on a timeout or NAK
+SMResult_t StratoPIB::AwaitAck(StateMachine & sm, bool acked, bool nak)
+{
+    const SMState_t & def = sm.Def();
+    uint8_t resend_class = ResendClass(def.resend_action);
+
+    if (acked) {
+        CancelTimer(def.resend_action);
+        latency.Acked(resend_class);
+        retry.Succeeded(resend_class);
+        return SM_DONE;
+    }
+
+    if (nak) {
+        link_stats[LINK_ZEPHYR].naks++;
+        CancelTimer(def.resend_action);
+        latency.Acked(resend_class); // a prompt NAK is still a round trip
+    } else if (!CheckAction(def.resend_action)) {
+        return SM_WAITING;
+    } else {
+        latency.TimedOut(resend_class);
+    }
+
+    if (sm.Retry(retry.Attempts(resend_class))) {
+        retry.Retried(resend_class);
+        CountResend(def.resend_action);
+        return SM_RETRY;
+    }
+
+    retry.Failed(resend_class);
+    if (NULL != def.fail_msg) ZephyrLogWarn(def.fail_msg);
+    return SM_FAILED;
+}
+
+// request permission to move the reel, a NAK fails immediately
+SMResult_t StratoPIB::AwaitRA(StateMachine & sm)
+{
+    if (sm.Entered()) {
+        RA_ack_flag = NO_ACK;
+        uint32_t tx_start = zephyr_link.TXBytes();
+        zephyrTX.RA();
+        CountZephyrTX(ZCAT_RA, tx_start);
+        ArmResend(sm);
+        log_nominal("Sending RA");
+    }
+
+    if (pibConfigs.ra_override.Read()) RA_ack_flag = ACK; // Over Ride RA requirement in an emergency or for testing
+
+    if (NAK == RA_ack_flag) {
+        link_stats[LINK_ZEPHYR].naks++;
+        CancelTimer(sm.Def().resend_action);
+        ZephyrLogWarn("Cannot perform motion, RA NAK");
+        return SM_FAILED;
+    }
+
+    SMResult_t result = AwaitAck(sm, ACK == RA_ack_flag);
+    if (SM_DONE == result) log_nominal("RA ACK");
+
+    return result;
+}
+
+SMResult_t StratoPIB::AwaitPUWarmup(StateMachine & sm)
+{
+    if (sm.Entered()) {
+        pu_warmup = false;
+        puComm.TX_WarmUp(pibConfigs.flash_temp.Read(),pibConfigs.heater1_temp.Read(),pibConfigs.heater2_temp.Read(),
+                         pibConfigs.flash_power.Read(),pibConfigs.tsen_power.Read());
+        ArmResend(sm);
+    }
+
+    return AwaitAck(sm, pu_warmup);
+}
+
+// start the motion set in mcb_motion and wait for the MCB to ack it
+SMResult_t StratoPIB::AwaitMotionStart(StateMachine & sm, float velocity)
+{
+    if (sm.Entered()) {
+        if (mcb_motion_ongoing) {
+            ZephyrLogWarn("Motion commanded while motion ongoing");
+            inst_substate = MODE_ERROR; // will force exit of the Flight state
+        }
+
+        if (!StartMCBMotion(velocity)) {
+            ZephyrLogWarn("Motion start error");
+            return SM_FAILED;
+        }
+
+        ArmResend(sm);
+    }
+
+    SMResult_t result = AwaitAck(sm, mcb_motion_ongoing); // set in the Ack handler
+    if (SM_DONE == result) log_nominal("MCB commanded motion");
+
+    return result;
+}
+
+// the TM is sent before entering the state, a retry resends the copy held by the XMLWriter
+SMResult_t StratoPIB::AwaitTMAck(StateMachine & sm)
+{
+    if (sm.Entered()) {
+        if (0 != sm.Attempts()) {
+            log_error("Needed to resend TM");
+            TM_ack_flag = NO_ACK;
+            SendZephyrTM(last_tm_category); // message is still saved in XMLWriter, no need to reconstruct
+        }
+        ArmResend(sm);
+    }
+
+    return AwaitAck(sm, ACK == TM_ack_flag, NAK == TM_ack_flag);
+}
+
 // --------------------------------------------------------
 // Profile helpers
 // --------------------------------------------------------
 
-bool StratoPIB::StartMCBMotion()
+bool StratoPIB::StartMCBMotion(float velocity)
 {
     bool success = false;
 
     switch (mcb_motion) {
     case MOTION_REEL_IN:
+    case MOTION_YOYO_IN:
+        if (velocity <= 0.0f) velocity = pibConfigs.retract_velocity.Read();
         snprintf(log_array, LOG_ARRAY_SIZE, "Retracting %0.1f revs", retract_length);
-        success = mcbComm.TX_Reel_In(retract_length, pibConfigs.retract_velocity.Read());
-        max_profile_seconds = 60 * (retract_length / pibConfigs.retract_velocity.Read()) + pibConfigs.motion_timeout.Read();
+        success = mcbComm.TX_Reel_In(retract_length, velocity);
+        max_profile_seconds = MotionSeconds(mcb_motion, retract_length, velocity) + pibConfigs.motion_timeout.Read();
+        StartMotionMonitor(retract_length, velocity);
         break;
     case MOTION_REEL_OUT:
+    case MOTION_YOYO_OUT:
+        if (velocity <= 0.0f) velocity = pibConfigs.deploy_velocity.Read();
         PUUndock();
         snprintf(log_array, LOG_ARRAY_SIZE, "Deploying %0.1f revs", deploy_length);
-        success = mcbComm.TX_Reel_Out(deploy_length, pibConfigs.deploy_velocity.Read());
-        max_profile_seconds = 60 * (deploy_length / pibConfigs.deploy_velocity.Read()) + pibConfigs.motion_timeout.Read();
+        success = mcbComm.TX_Reel_Out(deploy_length, velocity);
+        max_profile_seconds = MotionSeconds(mcb_motion, deploy_length, velocity) + pibConfigs.motion_timeout.Read();
+        StartMotionMonitor(deploy_length, velocity);
         break;
     case MOTION_DOCK:
+        if (velocity <= 0.0f) velocity = pibConfigs.dock_velocity.Read();
         snprintf(log_array, LOG_ARRAY_SIZE, "Docking %0.1f revs", dock_length);
-        success = mcbComm.TX_Dock(dock_length, pibConfigs.dock_velocity.Read());
-        max_profile_seconds = 60 * (dock_length / pibConfigs.dock_velocity.Read()) + pibConfigs.motion_timeout.Read();
+        success = mcbComm.TX_Dock(dock_length, velocity);
+        max_profile_seconds = MotionSeconds(MOTION_DOCK, dock_length, velocity) + pibConfigs.motion_timeout.Read();
+        StartMotionMonitor(dock_length, velocity);
         break;
     case MOTION_IN_NO_LW:
+        if (velocity <= 0.0f) velocity = pibConfigs.dock_velocity.Read();
         snprintf(log_array, LOG_ARRAY_SIZE, "Reel in (no LW) %0.1f revs", retract_length);
-        success = mcbComm.TX_In_No_LW(retract_length, pibConfigs.dock_velocity.Read());
-        max_profile_seconds = 60 * (retract_length / pibConfigs.dock_velocity.Read()) + pibConfigs.motion_timeout.Read();
+        success = mcbComm.TX_In_No_LW(retract_length, velocity);
+        max_profile_seconds = MotionSeconds(MOTION_IN_NO_LW, retract_length, velocity) + pibConfigs.motion_timeout.Read();
+        StartMotionMonitor(retract_length, velocity);
         break;
     default:
         mcb_motion = NO_MOTION;
@@ -263,26 +647,164 @@ bool StratoPIB::StartMCBMotion()
     return success;
 }
 
+// insert an entry in trigger order, false if the calendar is full
+bool StratoPIB::CalendarAdd(CalendarEntry_t entry)
+{
+    ProfileCalendar_t calendar = pibConfigs.profile_calendar.Read();
+    int i = CALENDAR_SIZE - 1;
+
+    if (UINT32_MAX != calendar.entries[CALENDAR_SIZE - 1].trigger) return false;
+
+    // shift later entries back to open a slot
+    while (i > 0 && calendar.entries[i - 1].trigger > entry.trigger) {
+        calendar.entries[i] = calendar.entries[i - 1];
+        i--;
+    }
+
+    calendar.entries[i] = entry;
+    return pibConfigs.profile_calendar.Write(calendar);
+}
+
+// remove and return the earliest entry
+CalendarEntry_t StratoPIB::CalendarPop()
+{
+    ProfileCalendar_t calendar = pibConfigs.profile_calendar.Read();
+    CalendarEntry_t head = calendar.entries[0];
+
+    for (int i = 0; i < CALENDAR_SIZE - 1; i++) {
+        calendar.entries[i] = calendar.entries[i + 1];
+    }
+    calendar.entries[CALENDAR_SIZE - 1] = {UINT32_MAX, 0.0f, 0, 0};
+
+    pibConfigs.profile_calendar.Write(calendar);
+    return head;
+}
+
+// autonomous profiles use the size scheduled for the night, manual profiles the config
+float StratoPIB::ProfileSize()
+{
+    if (autonomous_mode && scheduled_profile_size > 0.0f) return scheduled_profile_size;
+
+    return pibConfigs.profile_size.Read();
+}
+
+// expected wall time of one profile with the current configs
+uint32_t StratoPIB::ProfileSeconds()
+{
+    ProfileLeg_t legs[MAX_PROFILE_LEGS];
+    uint8_t count = BuildProfilePlan(legs);
+    float dock_amount = pibConfigs.dock_amount.Read();
+
+    return pibConfigs.puwarmup_time.Read() + pibConfigs.preprofile_time.Read() + PlanSeconds(legs, 0, count)
+           + MotionSeconds(MOTION_DOCK, dock_amount + pibConfigs.dock_overshoot.Read())
+           + pibConfigs.motion_timeout.Read() + PROFILE_MARGIN;
+}
+
+// seconds until the SZA falls back below sza_minimum, 0 if it can't be predicted
+uint32_t StratoPIB::DarkSecondsRemaining()
+{
+    uint32_t t_now = now();
+    uint32_t dawn = 0;
+
+    if (!EphemerisValid(t_now)) return 0;
+
+    dawn = PredictSZACrossing(t_now, zephyrRX.zephyr_gps.latitude, zephyrRX.zephyr_gps.longitude,
+                              pibConfigs.sza_minimum.Read(), DARK_PREDICT_HORIZON, false);
+
+    return (0 == dawn) ? 0 : dawn - t_now;
+}
+
 bool StratoPIB::ScheduleProfiles()
 {
-    // no matter the trigger, reset the time_trigger to the max value, new TC needed to set new value
-    pibConfigs.time_trigger.Write(UINT32_MAX);
+    uint8_t num_profiles = pibConfigs.num_profiles.Read();
+    uint32_t period = pibConfigs.profile_period.Read();
+    uint32_t duration = 0;
+    uint32_t dark_seconds = 0;
+
+    scheduled_profile_size = pibConfigs.profile_size.Read();
+
+    // a time trigger consumes the calendar entry, which may override the configs for the night
+    if (!pibConfigs.sza_trigger.Read()) {
+        CalendarEntry_t entry = CalendarPop();
+        if (0 != entry.num_profiles) num_profiles = entry.num_profiles;
+        if (0 != entry.profile_period) period = entry.profile_period;
+        if (entry.profile_size > 0.0f) scheduled_profile_size = entry.profile_size;
+    }
+
+    duration = ProfileSeconds();
+
+    // never start a profile before the previous one can finish
+    if (period < duration) period = duration;
+
+    // with the SZA trigger, only schedule the profiles that finish before dawn
+    if (pibConfigs.sza_trigger.Read()) dark_seconds = DarkSecondsRemaining();
 
-    // schedule the configured number of profiles starting in five seconds
-    for (int i = 0; i < pibConfigs.num_profiles.Read(); i++) {
-        if (!scheduler.AddAction(ACTION_BEGIN_PROFILE, i * pibConfigs.profile_period.Read() + 5)) {
+    if (0 != dark_seconds) {
+        uint8_t feasible = 0;
+        while (feasible < num_profiles && feasible * period + 5 + duration <= dark_seconds) feasible++;
+
+        snprintf(log_array, LOG_ARRAY_SIZE, "Profile plan: %u of %u fit in %lu s dark, %lu s each, %lu s period",
+                 feasible, num_profiles, dark_seconds, duration, period);
+        ZephyrLogFine(log_array);
+
+        num_profiles = feasible;
+        if (0 == num_profiles) ZephyrLogWarn("No profiles fit before dawn, none scheduled tonight");
+    }
+
+    // the autonomous loop waits for exactly the profiles scheduled here
+    profiles_remaining = num_profiles;
+
+    // schedule the profiles starting in five seconds
+    for (int i = 0; i < num_profiles; i++) {
+        if (!scheduler.AddAction(ACTION_BEGIN_PROFILE, i * period + 5)) {
             ZephyrLogCrit("Error scheduling profiles, scheduler failure");
             return false;
         }
     }
 
-    snprintf(log_array, LOG_ARRAY_SIZE, "Scheduled profiles: %u, %0.2f, %0.2f, %0.2f, %u, %u", pibConfigs.num_profiles.Read(),
-             pibConfigs.profile_size.Read(), pibConfigs.dock_amount.Read(), pibConfigs.dock_overshoot.Read(),
-             pibConfigs.dwell_time.Read(), pibConfigs.profile_period.Read());
+    snprintf(log_array, LOG_ARRAY_SIZE, "Scheduled profiles: %u, %0.2f, %0.2f, %0.2f, %u, %lu", num_profiles,
+             scheduled_profile_size, pibConfigs.dock_amount.Read(), pibConfigs.dock_overshoot.Read(),
+             pibConfigs.dwell_time.Read(), period);
     ZephyrLogFine(log_array);
     return true;
 }
 
+// only trust the ephemeris while it agrees with the Zephyr, otherwise fall back to the reported SZA
+bool StratoPIB::EphemerisValid(uint32_t t_now)
+{
+    if (!time_valid) return false;
+
+    float sza = SolarZenith(t_now, zephyrRX.zephyr_gps.latitude, zephyrRX.zephyr_gps.longitude);
+
+    return fabsf(sza - zephyrRX.zephyr_gps.solar_zenith_angle) <= SZA_TOLERANCE;
+}
+
+// start the profile early enough that the reel out begins as the SZA crosses sza_minimum
+bool StratoPIB::SZATriggerPredicted()
+{
+    uint32_t t_now = now();
+    float latitude = zephyrRX.zephyr_gps.latitude;
+    float longitude = zephyrRX.zephyr_gps.longitude;
+
+    if (!EphemerisValid(t_now)) return false;
+
+    // refresh the prediction as the balloon drifts
+    if (0 == sza_predict_time || t_now - sza_predict_time >= SZA_PREDICT_PERIOD) {
+        sza_predict_time = t_now;
+        sza_trigger_time = PredictSZACrossing(t_now, latitude, longitude, pibConfigs.sza_minimum.Read(), SZA_PREDICT_HORIZON);
+
+        if (0 != sza_trigger_time) {
+            snprintf(log_array, LOG_ARRAY_SIZE, "Predicted SZA trigger in %lu s", sza_trigger_time - t_now);
+            log_nominal(log_array);
+        }
+    }
+
+    if (0 == sza_trigger_time) return false;
+
+    // the reel out follows the warmup and the pre-profile wait
+    return t_now + pibConfigs.puwarmup_time.Read() + pibConfigs.preprofile_time.Read() >= sza_trigger_time;
+}
+
 void StratoPIB::AddMCBTM()
 {
     // make sure it's the correct size
@@ -315,7 +837,7 @@ void StratoPIB::AddMCBTM()
         zephyrTX.setStateFlagValue(1, FINE);
         zephyrTX.setStateFlagValue(2, NOMESS);
         zephyrTX.setStateFlagValue(3, NOMESS);
-        zephyrTX.TM();
+        SendZephyrTM(ZCAT_MCB_TM);
         log_nominal(log_array);
         MCB_TM_buffer_idx = 0; //reser the MCB buffer pointer
     }
@@ -344,6 +866,17 @@ void StratoPIB::NoteProfileStart()
 
 }
 
+// true if the finished reel in left the PU within dock_window revs of the dock, using a position from this motion
+bool StratoPIB::ReelInDockWindow()
+{
+    if (mcb_motion_ongoing) return false;
+
+    // the position must have been reported since the motion started
+    if ((int32_t) (reel_position_time - profile_start) < 0) return false;
+
+    return fabsf(fabsf(reel_position) - pibConfigs.dock_amount.Read()) <= pibConfigs.dock_window.Read();
+}
+
 void StratoPIB::SendMCBTM(StateFlag_t state_flag, const char * message)
 {
     // use only the first flag to report the motion
@@ -354,7 +887,7 @@ void StratoPIB::SendMCBTM(StateFlag_t state_flag, const char * message)
     zephyrTX.setStateFlagValue(3, NOMESS);
 
     TM_ack_flag = NO_ACK;
-    zephyrTX.TM();
+    SendZephyrTM(ZCAT_MCB_TM);
 
     log_nominal(log_array);
     MCB_TM_buffer_idx = 0;
@@ -378,7 +911,7 @@ void StratoPIB::SendMCBEEPROM()
 
     // send as TM
     TM_ack_flag = NO_ACK;
-    zephyrTX.TM();
+    SendZephyrTM(ZCAT_EEPROM);
 
     log_nominal("Sent MCB EEPROM as TM");
 }
@@ -405,18 +938,43 @@ void StratoPIB::SendPIBEEPROM()
 
     // send as TM
     TM_ack_flag = NO_ACK;
-    zephyrTX.TM();
+    SendZephyrTM(ZCAT_EEPROM);
 
     log_nominal("Sent PIB EEPROM as TM");
 }
 
+// version (u8), PU time (u32), v_battery, i_charge, therm1, therm2 (f32), heater_stat (u8), big-endian
+bool StratoPIB::AddPUStatusTM()
+{
+    uint8_t block[PU_STATUS_BLOCK_SIZE];
+    uint32_t fields[5] = {pu_status.time, 0, 0, 0, 0};
+    uint8_t index = 0;
+
+    memcpy(&fields[1], &pu_status.v_battery, sizeof(float));
+    memcpy(&fields[2], &pu_status.i_charge, sizeof(float));
+    memcpy(&fields[3], &pu_status.therm1, sizeof(float));
+    memcpy(&fields[4], &pu_status.therm2, sizeof(float));
+
+    block[index++] = PU_STATUS_VERSION;
+    for (uint8_t i = 0; i < 5; i++) {
+        block[index++] = (uint8_t) (fields[i] >> 24);
+        block[index++] = (uint8_t) (fields[i] >> 16);
+        block[index++] = (uint8_t) (fields[i] >> 8);
+        block[index++] = (uint8_t) fields[i];
+    }
+    block[index++] = pu_status.heater_stat;
+
+    return zephyrTX.addTm(block, index);
+}
+
 void StratoPIB::SendTSENTM()
 {
-    if (0 < snprintf(log_array, LOG_ARRAY_SIZE, "PU TSEN: %lu, %0.2f, %0.2f, %0.2f, %0.2f, %u", pu_status.time, pu_status.v_battery, pu_status.i_charge, pu_status.therm1, pu_status.therm2, pu_status.heater_stat)) {
-        zephyrTX.setStateDetails(1, log_array);
+    // the TSEN record is already in the TM buffer, the status block follows it
+    if (AddPUStatusTM()) {
+        zephyrTX.setStateDetails(1, "PU TSEN");
         zephyrTX.setStateFlagValue(1, FINE);
     } else {
-        zephyrTX.setStateDetails(1, "PU TSEN: unable to add status info");
+        zephyrTX.setStateDetails(1, "PU TSEN: unable to add status block");
         zephyrTX.setStateFlagValue(1, WARN);
     }
 
@@ -425,18 +983,21 @@ void StratoPIB::SendTSENTM()
     zephyrTX.setStateFlagValue(3, NOMESS);
 
     TM_ack_flag = NO_ACK;
-    zephyrTX.TM();
+    SendZephyrTM(ZCAT_TSEN);
 
-    log_nominal(log_array);
+    trace.Log(TR_TSEN_TM, pu_status.time, PIBTrace::Float(pu_status.v_battery), PIBTrace::Float(pu_status.i_charge),
+              PIBTrace::Float(pu_status.therm1), PIBTrace::Float(pu_status.therm2), pu_status.heater_stat);
 }
 
 void StratoPIB::SendProfileTM(uint8_t packet_num)
 {
-    if (0 < snprintf(log_array, LOG_ARRAY_SIZE, "PU Prof. Rec. %u.%u: %lu, %0.2f, %0.2f, %0.2f, %0.2f, %u", pibConfigs.profile_id.Read(), packet_num, pu_status.time, pu_status.v_battery, pu_status.i_charge, pu_status.therm1, pu_status.therm2, pu_status.heater_stat)) {
+    // the profile record is already in the TM buffer, the status block follows it
+    if (AddPUStatusTM()) {
+        snprintf(log_array, LOG_ARRAY_SIZE, "PU Prof. Rec. %u.%u", pibConfigs.profile_id.Read(), packet_num);
         zephyrTX.setStateDetails(1, log_array);
         zephyrTX.setStateFlagValue(1, FINE);
     } else {
-        zephyrTX.setStateDetails(1, "PU Profile Record: unable to add status info");
+        zephyrTX.setStateDetails(1, "PU Profile Record: unable to add status block");
         zephyrTX.setStateFlagValue(1, WARN);
     }
 
@@ -445,23 +1006,65 @@ void StratoPIB::SendProfileTM(uint8_t packet_num)
     zephyrTX.setStateFlagValue(3, NOMESS);
 
     TM_ack_flag = NO_ACK;
-    zephyrTX.TM();
+    SendZephyrTM(ZCAT_PROFILE);
 
-    log_nominal(log_array);
+    trace.Log(TR_PROFILE_TM, ((uint32_t) pibConfigs.profile_id.Read() << 16) | ((uint32_t) packet_num << 8) | pu_status.heater_stat,
+              pu_status.time, PIBTrace::Float(pu_status.v_battery), PIBTrace::Float(pu_status.i_charge),
+              PIBTrace::Float(pu_status.therm1), PIBTrace::Float(pu_status.therm2));
 }
 
-// every 10 minutes, aligned with the hour (called in InstrumentLoop)
+void StratoPIB::SendPUStatusTM()
+{
+    zephyrTX.clearTm();
+
+    if (AddPUStatusTM()) {
+        zephyrTX.setStateDetails(1, "PU status");
+        zephyrTX.setStateFlagValue(1, FINE);
+    } else {
+        zephyrTX.setStateDetails(1, "PU status: unable to add status block");
+        zephyrTX.setStateFlagValue(1, WARN);
+    }
+
+    zephyrTX.setStateFlagValue(2, NOMESS);
+    zephyrTX.setStateFlagValue(3, NOMESS);
+
+    TM_ack_flag = NO_ACK;
+    SendZephyrTM(ZCAT_TSEN);
+
+    log_nominal("Sent PU status TM");
+}
+
+// every tsen_period seconds (called in InstrumentLoop)
 void StratoPIB::CheckTSEN()
 {
     static time_t last_tsen = 0;
 
-    // check if it's been at least 9 minutes and the current minute is a multiple of 10
-    if ((now() > last_tsen + 540) && (0 == minute() % 10)) {
+    if (now() >= last_tsen + tsen_period) {
         last_tsen = now();
         SetAction(COMMAND_SEND_TSEN);
     }
 }
 
+// called when Flight_TSEN has drained the PU: poll faster if a backlog had built up,
+// back off if the PU had nothing new, and keep the period if it had exactly one record
+void StratoPIB::AdaptTSENPeriod()
+{
+    uint16_t min_period = pibConfigs.tsen_min_period.Read();
+    uint16_t max_period = pibConfigs.tsen_max_period.Read();
+
+    if (tsen_records > 1) {
+        tsen_period /= 2;
+    } else if (0 == tsen_records) {
+        tsen_period = (tsen_period > UINT16_MAX / 2) ? UINT16_MAX : 2 * tsen_period;
+    }
+
+    if (tsen_period < min_period) tsen_period = min_period;
+    if (tsen_period > max_period) tsen_period = max_period;
+
+    snprintf(log_array, LOG_ARRAY_SIZE, "TSEN backlog %u, next poll in %u s", tsen_records, tsen_period);
+    log_nominal(log_array);
+}
+
 void StratoPIB::PUDock()
 {
     pibConfigs.pu_docked.Write(true);
@@ -470,19 +1073,28 @@ void StratoPIB::PUDock()
 
 void StratoPIB::PUUndock()
 {
+    // only start a new relay session on the transition
+    if (pibConfigs.pu_docked.Read()) lora_link.Reset(pibConfigs.lora_sf.Read(), now());
+
     pibConfigs.pu_docked.Write(false);
     digitalWrite(PU_PWR_ENABLE, LOW);
 }
 
 void StratoPIB::PUStartProfile()
 {
-    int32_t t_down = 60 * (deploy_length / pibConfigs.deploy_velocity.Read()) + pibConfigs.preprofile_time.Read();
-    int32_t t_up = 60 * (retract_length / pibConfigs.retract_velocity.Read() + dock_length / pibConfigs.dock_velocity.Read())
+    uint8_t deploy_legs = 1;
+
+    // the PU samples the deploy legs on the way down, dwells, then samples every later leg (yo-yo casts included) on the way up
+    while (deploy_legs < num_legs && MOTION_REEL_OUT == profile_legs[deploy_legs].motion) deploy_legs++;
+    uint16_t dwell = profile_legs[deploy_legs - 1].dwell;
+
+    int32_t t_down = PlanSeconds(profile_legs, 0, deploy_legs) - dwell + pibConfigs.preprofile_time.Read();
+    int32_t t_up = PlanSeconds(profile_legs, deploy_legs, num_legs) + MotionSeconds(MOTION_DOCK, dock_length)
                    + pibConfigs.motion_timeout.Read(); // extra time for dock delay
 
-    puComm.TX_Profile(t_down, pibConfigs.dwell_time.Read(), t_up, pibConfigs.profile_rate.Read(), pibConfigs.dwell_rate.Read(),
+    puComm.TX_Profile(t_down, dwell, t_up, pibConfigs.profile_rate.Read(), pibConfigs.dwell_rate.Read(),
                       pibConfigs.profile_TSEN.Read(), pibConfigs.profile_ROPC.Read(), pibConfigs.profile_FLASH.Read(),pibConfigs.lora_tx_tm.Read());
-    Serial.printf("Profile Params Sent to PU: %d, %d, %d, %d,%d, %d, %d, %d, %d\n",t_down, pibConfigs.dwell_time.Read(), t_up, pibConfigs.profile_rate.Read(), pibConfigs.dwell_rate.Read(),
+    Serial.printf("Profile Params Sent to PU: %d, %d, %d, %d,%d, %d, %d, %d, %d\n",t_down, dwell, t_up, pibConfigs.profile_rate.Read(), pibConfigs.dwell_rate.Read(),
                       pibConfigs.profile_TSEN.Read(), pibConfigs.profile_ROPC.Read(), pibConfigs.profile_FLASH.Read(),pibConfigs.lora_tx_tm.Read());
     pibConfigs.profile_id.Write(pibConfigs.profile_id.Read()+1); //increment the profile counter
 }
\ No newline at end of file
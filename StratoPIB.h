@@ -15,14 +15,27 @@
 #include "PIBHardware.h"
 #include "PIBBufferGuard.h"
 #include "PIBConfigs.h"
+#include "PIBTimers.h"
+#include "PIBLatency.h"
+#include "PIBRetry.h"
+#include "PIBLinkStats.h"
+#include "PIBDispatch.h"
+#include "PIBTrace.h"
+#include "PIBZephyrLog.h"
+#include "PIBLoRaLink.h"
+#include "PIBStateMachine.h"
+#include "SolarPosition.h"
 #include "MCBComm.h"
 #include "PUComm.h"
 #include <LoRa.h> //LoRa Library from: https://github.com/sandeepmistry/arduino-LoRa
 
 #define INSTRUMENT      RACHUTS
 
-// number of loops before a flag becomes stale and is reset
-#define FLAG_STALE      3
+// seconds before a time-critical action flag expires (three loops at the 1 Hz loop rate)
+#define ACTION_TTL_DEFAULT      3
+
+// scheduled profile starts wait this long for the previous sequence to finish
+#define ACTION_TTL_PROFILE      900
 
 #define MCB_RESEND_TIMEOUT      10
 #define PU_RESEND_TIMEOUT       10
@@ -30,14 +43,23 @@
 
 #define RETRY_DOCK_LENGTH   2.0f
 
+// starting TSEN polling period, adapted within the configured bounds
+#define TSEN_DEFAULT_PERIOD 600
+
+// SZA trigger prediction: refresh period and search horizon (s), allowed disagreement with the Zephyr (deg)
+#define SZA_PREDICT_PERIOD  300
+#define SZA_PREDICT_HORIZON 43200
+#define SZA_TOLERANCE       2.0f
+
+// how far ahead to look for dawn (s), and allowance for handshakes and TSEN in a profile (s)
+#define DARK_PREDICT_HORIZON    86400
+#define PROFILE_MARGIN          300
+
 #define MCB_BUFFER_SIZE     MAX_MCB_BINARY
 #define PU_BUFFER_SIZE      8192
 //LoRa Settings
 #define FREQUENCY 868E6
-#define BANDWIDTH 250E3
-#define SF 10
-#define RF_POWER 14
-#define LORA_TM_TIMEOUT 600
+#define LORA_TM_TIMEOUT 600 // also the shortest LoRa contact timeout
 
 // todo: update naming to be more unique (ie. ACT_ prefix)
 enum ScheduleAction_t : uint8_t {
@@ -75,26 +97,88 @@ enum ScheduleAction_t : uint8_t {
     ACTION_OVERRIDE_TSEN, // if TSEN in manual, override for command
     ACTION_OFFLOAD_PU,
     ACTION_MOTION_TIMEOUT,
+    ACTION_MOTION_STALL,
     ACTION_END_DOCK_WAIT,
+    ACTION_SEQUENCE_WAIT,
+    ACTION_SEND_HK,
+    ACTION_SEND_LORA_STATUS,
 
     // Multi-action commands
     COMMAND_REDOCK,    // reel out, reel in (no lw), check PU
     COMMAND_SEND_TSEN, // check PU, request TSEN, send TM
     COMMAND_MANUAL_PROFILE,
     COMMAND_DOCKED_PROFILE,
+    COMMAND_RUN_SEQUENCE,
 
     // used for tracking
     NUM_ACTIONS
 };
 
+// every action can have one armed timer at a time
+static_assert(NUM_ACTIONS <= TIMER_POOL_SIZE, "TIMER_POOL_SIZE must cover every action");
+
+// each resend action is its own command class, with its own round-trip estimate and retry policy
+#define NUM_RESEND_CLASSES  (RESEND_FULL_RETRACT - RESEND_SAFETY + 1)
+static_assert(NUM_RESEND_CLASSES <= NUM_RTT_CLASSES, "NUM_RTT_CLASSES must cover every resend action");
+static_assert(NUM_RESEND_CLASSES <= NUM_RETRY_CLASSES, "NUM_RETRY_CLASSES must cover every resend action");
+
 enum MCBMotion_t : uint8_t {
     NO_MOTION,
     MOTION_REEL_IN,
     MOTION_REEL_OUT,
     MOTION_DOCK,
-    MOTION_IN_NO_LW
+    MOTION_IN_NO_LW,
+    MOTION_YOYO_IN,  // reel in to the top of a yo-yo cast
+    MOTION_YOYO_OUT  // reel out to the bottom of a yo-yo cast
+};
+
+// enough for the deploy, the yo-yo casts, and a stepped final retract, split at velocity band edges
+#define MAX_PROFILE_LEGS    64
+
+// one motion of a profile, followed by an optional dwell
+struct ProfileLeg_t {
+    MCBMotion_t motion;
+    float length;       // revolutions
+    float velocity;     // rpm, 0 for the configured velocity
+    uint16_t dwell;     // seconds
+};
+
+// an action flag waiting to be served by a mode, re-raising it while pending coalesces
+struct PendingAction_t {
+    bool pending;
+    uint8_t coalesced;
+    uint32_t enqueue_ms;
+};
+
+struct WorkQueueStats_t {
+    uint8_t depth;
+    uint8_t peak_depth;
+    uint16_t served;
+    uint16_t expired;
+    uint16_t coalesced;
+    uint32_t max_latency_ms;
+    uint32_t total_latency_ms;
 };
 
+// LoRa status records batched into one TM (in LoRaStatus.cpp)
+#define LORA_STATUS_RECORDS     16
+
+struct LoRaStatus_t {
+    uint32_t rx_time;
+    int16_t rssi;       // dBm
+    int8_t snr;         // 0.25 dB
+    uint32_t pu_time;
+    float v_battery;
+    float i_charge;
+    float therm1;
+    float therm2;
+    uint8_t heater_stat;
+};
+
+// packed PU status block appended to PU TM payloads (see AddPUStatusTM)
+#define PU_STATUS_VERSION       1
+#define PU_STATUS_BLOCK_SIZE    22
+
 struct PUStatus_t {
     uint32_t last_status;
     uint32_t time;
@@ -122,8 +206,27 @@ public:
     void LoRaRX();
     void LoRaInit();
 
+    // apply the radio configs, and track the link to recommend a spreading factor
+    void LoRaApplyRadio();
+    void CheckLoRaLink();
+
+    // batch LoRa status packets into one TM (in LoRaStatus.cpp)
+    void HandleLoRaStatus(const char * packet, int rssi, float snr);
+    void CheckLoRaStatus();
+    void SendLoRaStatusTM();
+
 
 private:
+    // traffic and error counters per link, and Zephyr TX bytes per category (in Housekeeping.cpp)
+    LinkStats_t link_stats[NUM_LINKS] = {{0}};
+    uint32_t zephyr_tx_bytes[NUM_ZEPHYR_CATEGORIES] = {0};
+    uint8_t last_tm_category = ZCAT_MCB_TM;
+
+    // counting wrappers for the Zephyr, MCB, and PU serial ports, constructed before the comm objects
+    PIBLinkStream zephyr_link;
+    PIBLinkStream mcb_link;
+    PIBLinkStream pu_link;
+
     // internal serial interface objects for the MCB and PU
     MCBComm mcbComm;
     PUComm puComm;
@@ -152,6 +255,14 @@ private:
     bool Flight_TSEN(bool restart_state);
     bool Flight_ManualMotion(bool restart_state);
     bool Flight_DockedProfile(bool restart_state);
+    bool Flight_Sequence(bool restart_state);
+
+    // run the uploaded sequence's instructions for this loop (in Flight_Sequence.cpp)
+    bool RunSequence();
+
+    // the actions a sequence may raise or wait on, internal flags are excluded (in Flight_Sequence.cpp)
+    static const uint8_t sequence_actions[];
+    static const uint8_t num_sequence_actions;
 
     // Telcommand handler - returns ack/nak
     void TCHandler(Telecommand_t telecommand);
@@ -165,34 +276,117 @@ private:
     // Correctly set an action flag
     void SetAction(uint8_t action);
 
-    // Monitor the action flags and clear old ones
+    // Drop a pending action flag without serving it
+    void DropAction(uint8_t action);
+    void ClearActions();
+
+    // Seconds an action flag stays pending before it expires, 0 for never
+    uint16_t ActionTTL(uint8_t action);
+
+    // Monitor the action flags and expire old ones
     void WatchFlags();
 
+    // Arm (or re-arm) the one-shot timer that sets an action flag after a delay
+    bool ScheduleTimer(uint8_t action, uint32_t seconds);
+
+    // Disarm an action's timer and drop its flag if it already fired
+    void CancelTimer(uint8_t action);
+
+    // Advance the timer wheel and set the flags of expired timers
+    void RunTimers();
+
+    // State machine steps shared by the Flight_* sequences (in StratoPIB.cpp)
+    // each sends on entry, arms the state's resend timer, and applies its retry policy
+    uint8_t ResendClass(uint8_t resend_action);
+    uint16_t ResendTimeout(uint8_t resend_action, uint8_t attempt);
+    static void ExitState(void * owner, uint8_t resend_action);
+    void ArmResend(StateMachine & sm);
+
+    // the same retry policy for the mode sequences that resend without a state machine,
+    // attempts is the caller's send count for the command, one per resend class
+    void ScheduleResend(uint8_t resend_action, uint8_t & attempts);
+    void ResendAcked(uint8_t resend_action, uint8_t & attempts);
+    SMResult_t AwaitAck(StateMachine & sm, bool acked, bool nak = false);
+    SMResult_t AwaitRA(StateMachine & sm);
+    SMResult_t AwaitPUWarmup(StateMachine & sm);
+    SMResult_t AwaitMotionStart(StateMachine & sm, float velocity = 0.0f);
+    SMResult_t AwaitTMAck(StateMachine & sm);
+
+    // route a message through a router's table, counting it (in MessageDispatch.cpp)
+    void DispatchMessage(SerialComm & comm, SerialMessage_t type, uint8_t link,
+                         const MessageRoute_t * routes, RouteStats_t * stats, uint8_t num_routes);
+
     // Handle messages from the MCB (in MCBRouter.cpp)
-    void HandleMCBASCII();
-    void HandleMCBAck();
-    void HandleMCBBin();
-    void HandleMCBString();
+    static const MessageRoute_t mcb_routes[];
+    static const uint8_t num_mcb_routes;
+    static RouteStats_t mcb_route_stats[];
+    void HandleMCBMotionFinished();
+    void HandleMCBMotionFault();
+    void HandleMCBLowPowerAck();
+    void HandleMCBMotionAck();
+    void HandleMCBRetractAck();
+    void HandleMCBMotionTM();
+    void HandleMCBError();
     uint8_t binary_mcb[MCB_BUFFER_SIZE];
 
     // Handle messages from the PU (in PURouter.cpp)
-    void HandlePUASCII();
-    void HandlePUAck();
-    void HandlePUBin();
-    void HandlePUString();
+    static const MessageRoute_t pu_routes[];
+    static const uint8_t num_pu_routes;
+    static RouteStats_t pu_route_stats[];
+    void HandlePUStatus();
+    void HandlePUNoMoreRecords();
+    void HandlePUWarmupAck();
+    void HandlePUProfileAck();
+    void HandlePUPreprofileAck();
+    void HandlePUTSENRecord();
+    void HandlePUProfileRecord();
+    bool AcceptPURecord();
+    void HandlePUError();
     uint8_t binary_pu[PU_BUFFER_SIZE];
 
     // Start any type of MCB motion
-    bool StartMCBMotion();
+    bool StartMCBMotion(float velocity = 0.0f);
+
+    // Predict motion durations and learn from completed motions (in MotionModel.cpp)
+    float MotionSeconds(MCBMotion_t motion, float length, float velocity = 0.0f);
+    float MotionRampSeconds(MCBMotion_t motion, float length, float velocity);
+    void LearnMotionTime();
+
+    // Watch reel progress for a stall (in MotionMonitor.cpp)
+    void StartMotionMonitor(float length, float velocity);
+    void MonitorMotion(float position);
+    bool HandleMotionStall();
 
     // Schedule profiles in autonomous mode
     bool ScheduleProfiles();
 
+    // true once the predicted SZA trigger is within the profile preparation time
+    bool EphemerisValid(uint32_t t_now);
+    bool SZATriggerPredicted();
+
+    // time-triggered profile calendar, kept sorted by trigger in EEPROM
+    bool CalendarAdd(CalendarEntry_t entry);
+    CalendarEntry_t CalendarPop();
+    uint32_t NextCalendarTrigger() { return pibConfigs.profile_calendar.Read().entries[0].trigger; }
+    float ProfileSize();
+
+    // lay out the motions of a profile (in ProfilePlan.cpp)
+    uint8_t BuildProfilePlan(ProfileLeg_t * legs);
+    uint32_t PlanSeconds(const ProfileLeg_t * legs, uint8_t first, uint8_t last);
+    bool AddProfileStop(ProfileStop_t stop);
+    bool AddVelocityBand(VelocityBand_t band);
+    const char * LegName(MCBMotion_t motion);
+
+    // fit the night's profiles into the predicted dark window
+    uint32_t ProfileSeconds();
+    uint32_t DarkSecondsRemaining();
+
     // Add an MCB motion TM packet to the binary TM buffer
     void AddMCBTM();
 
     // Set variables and TM buffer after a profile starts
     void NoteProfileStart();
+    bool ReelInDockWindow();
 
     // Send a telemetry packet with MCB binary info
     void SendMCBTM(StateFlag_t state_flag, const char * message);
@@ -205,9 +399,36 @@ private:
     void SendTSENTM();
     void SendProfileTM(uint8_t packet_num);
 
-    // sets an action flag every ten minutes aligned with the hour
+    // append the packed PU status block to the TM buffer, and send it alone as a TM
+    bool AddPUStatusTM();
+    void SendPUStatusTM();
+
+    // sets an action flag every tsen_period seconds
     void CheckTSEN();
 
+    // sets an action flag every hk_period seconds, served when a flight mode is idle (in Housekeeping.cpp)
+    void CheckHousekeeping();
+    void SendHousekeepingTM();
+
+    // send the per-route message counts and handler times, on request
+    void SendRouteStatsTM();
+
+    // send the TM held in zephyrTX, counting its bytes under the category (ZephyrCategory_t)
+    void SendZephyrTM(uint8_t category);
+    void CountZephyrTX(uint8_t category, uint32_t tx_start);
+
+    // count a resend under the link its retry policy sends to
+    void CountResend(uint8_t resend_action);
+
+    // hide StratoCore's Zephyr log functions to fold repeats within log_window seconds
+    void ZephyrLogFine(const char * log_info);
+    void ZephyrLogWarn(const char * log_info);
+    void ZephyrLogCrit(const char * log_info);
+    void FlushZephyrLogs();
+
+    // adapt tsen_period to the backlog drained by the last Flight_TSEN
+    void AdaptTSENPeriod();
+
     // call every time the known state of the PU changes
     void PUDock();
     void PUUndock();
@@ -215,7 +436,25 @@ private:
     // PU start profile command generation and transmit
     void PUStartProfile();
 
-    ActionFlag_t action_flags[NUM_ACTIONS] = {{0}}; // initialize all flags to false
+    // pending work, one coalescing entry per action
+    PendingAction_t pending_actions[NUM_ACTIONS] = {{0}}; // initialize all flags to false
+    WorkQueueStats_t work_stats = {0};
+
+    // timer wheel for one-shot actions, with at most one armed timer per action
+    PIBTimers timers;
+    TimerHandle_t action_timers[NUM_ACTIONS];
+    uint32_t timer_seconds = 0; // monotonic, survives millis() rollover
+    uint32_t timer_millis = 0;
+
+    // round-trip times and adaptive resend timeouts, and the retry policy, per resend action
+    PIBLatency latency;
+    PIBRetry retry;
+
+    // tokenized debug log for hot paths, drained in InstrumentLoop
+    PIBTrace trace;
+
+    // folds repeated Zephyr log messages, flushed in InstrumentLoop
+    PIBZephyrLog zephyrLog;
 
     // track the flight mode (autonomous/manual)
     bool autonomous_mode = false;
@@ -237,13 +476,45 @@ private:
     bool pu_preprofile = false;
     bool check_pu_success = false;
 
+    // adaptive TSEN polling: current period and records drained in this poll
+    uint16_t tsen_period = TSEN_DEFAULT_PERIOD;
+    uint8_t tsen_records = 0;
+
     // tracks the number of profiles remaining in autonomous mode and if they're scheduled
     uint8_t profiles_remaining = 0;
     bool profiles_scheduled = false;
 
+    // profile size for tonight's scheduled profiles, from the calendar entry or profile_size
+    float scheduled_profile_size = 0.0f;
+
+    // the last profile's records are waiting to be offloaded during the next profile's warmup
+    bool offload_pending = false;
+
+    // set to stop an offload before its next record, stays set if the offload stopped with records left
+    bool offload_yield = false;
+
+    // predicted time at which the SZA rises through sza_minimum, and when it was predicted
+    uint32_t sza_trigger_time = 0;
+    uint32_t sza_predict_time = 0;
+
     // uint32_t start time of the current profile in millis
     uint32_t profile_start = 0;
 
+    // last reel position reported in an MCB motion TM, and when it arrived in millis
+    float reel_position = 0.0f;
+    uint32_t reel_position_time = 0;
+
+    // stall monitor state for the current motion (revs and rpm)
+    float commanded_length = 0.0f;
+    float commanded_velocity = 0.0f;
+    float monitor_start_position = 0.0f;
+    float monitor_last_position = 0.0f;
+    uint32_t monitor_last_time = 0;
+    uint32_t monitor_start_time = 0;
+    uint32_t monitor_ramp_ms = 0;
+    bool monitor_primed = false;
+    uint8_t stall_count = 0;
+
     // tracks the current type of motion
     MCBMotion_t mcb_motion = NO_MOTION;
 
@@ -252,6 +523,14 @@ private:
     float retract_length = 0.0f;
     float dock_length = 0.0f;
 
+    // motions of the current profile, up to the dock
+    ProfileLeg_t profile_legs[MAX_PROFILE_LEGS];
+    uint8_t num_legs = 0;
+    uint8_t leg_index = 0;
+
+    // sequence being uploaded by telecommand, saved to EEPROM once complete
+    Sequence_t sequence_upload = {0};
+
     // current docked profile duration
     uint16_t docked_profile_time = 0;
 
@@ -270,6 +549,11 @@ private:
     bool Send_LoRa_status = true;
     uint8_t LoRa_RX_buffer[256] = {0};
     char LoRa_PU_status[256] = {0};
+    PIBLoRaLink lora_link;
+    LoRaStatus_t lora_status[LORA_STATUS_RECORDS];
+    uint8_t lora_status_count = 0;
+    uint32_t lora_status_first = 0;
+    uint8_t lora_status_dropped = 0;
     
     uint8_t LoRa_TM_buffer[8192] = {0};
     uint16_t LoRa_TM_buffer_idx = 0;
@@ -13,6 +13,7 @@ void StratoPIB::TCHandler(Telecommand_t telecommand)
 {
     String dbg_msg = "";
     log_debug("Received telecommand");
+    link_stats[LINK_ZEPHYR].rx_msgs++;
 
     switch (telecommand) {
 
@@ -34,6 +35,8 @@ void StratoPIB::TCHandler(Telecommand_t telecommand)
     case DEPLOYa:
         if (!mcbComm.TX_Out_Acc(mcbParam.deployAcc)) {
             ZephyrLogWarn("Error sending deploy acc to MCB");
+        } else {
+            pibConfigs.deploy_acc.Write(mcbParam.deployAcc); // keep the motion time model in step with the MCB
         }
         break;
     case RETRACTx:
@@ -53,6 +56,8 @@ void StratoPIB::TCHandler(Telecommand_t telecommand)
     case RETRACTa:
         if (!mcbComm.TX_In_Acc(mcbParam.retractAcc)) {
             ZephyrLogWarn("Error sending retract acc to MCB");
+        } else {
+            pibConfigs.retract_acc.Write(mcbParam.retractAcc); // keep the motion time model in step with the MCB
         }
         break;
     case DOCKx:
@@ -72,6 +77,8 @@ void StratoPIB::TCHandler(Telecommand_t telecommand)
     case DOCKa:
         if (!mcbComm.TX_Dock_Acc(mcbParam.dockAcc)) {
             ZephyrLogWarn("Error sending dock acc to MCB");
+        } else {
+            pibConfigs.dock_acc.Write(mcbParam.dockAcc); // keep the motion time model in step with the MCB
         }
         break;
     case FULLRETRACT:
@@ -168,15 +175,31 @@ void StratoPIB::TCHandler(Telecommand_t telecommand)
         ZephyrLogFine(log_array);
         break;
     case SETTIMETRIGGER:
+    case ADDCALENDARENTRY:
         if ((uint32_t) now() > pibParam.timeTrigger) {
             snprintf(log_array, LOG_ARRAY_SIZE, "Can't use time trigger in past: %lu is less than %lu", pibParam.timeTrigger, (uint32_t) now());
             ZephyrLogWarn(log_array);
             break;
         }
-        pibConfigs.time_trigger.Write(pibParam.timeTrigger);
-        snprintf(log_array, LOG_ARRAY_SIZE, "Set time_trigger: %lu", pibConfigs.time_trigger.Read());
+        {
+            // a bare time trigger runs the current configs, a calendar entry carries its own
+            CalendarEntry_t entry = {pibParam.timeTrigger, 0.0f, 0, 0};
+            if (ADDCALENDARENTRY == telecommand) {
+                entry.profile_size = pibParam.calProfileSize;
+                entry.profile_period = pibParam.calProfilePeriod;
+                entry.num_profiles = pibParam.calNumProfiles;
+            }
+            if (!CalendarAdd(entry)) {
+                ZephyrLogWarn("Profile calendar full");
+                break;
+            }
+        }
+        snprintf(log_array, LOG_ARRAY_SIZE, "Added time trigger: %lu, next %lu", pibParam.timeTrigger, NextCalendarTrigger());
         ZephyrLogFine(log_array);
-        profiles_remaining = pibConfigs.num_profiles.Read();
+        break;
+    case CLEARCALENDAR:
+        pibConfigs.profile_calendar.Write(PIBConfigs::EmptyCalendar());
+        ZephyrLogFine("Cleared profile calendar");
         break;
     case USESZATRIGGER:
         pibConfigs.sza_trigger.Write(true);
@@ -283,6 +306,13 @@ void StratoPIB::TCHandler(Telecommand_t telecommand)
             SendPIBEEPROM();
         }
         break;
+    case GETROUTESTATS:
+        if (mcb_motion_ongoing) {
+            ZephyrLogWarn("Motion ongoing, request route stats later");
+        } else {
+            SendRouteStatsTM();
+        }
+        break;
     case DOCKEDPROFILE:
         if (autonomous_mode) {
             ZephyrLogWarn("Switch to manual mode before commanding docked profile");
@@ -297,6 +327,71 @@ void StratoPIB::TCHandler(Telecommand_t telecommand)
         SetAction(COMMAND_DOCKED_PROFILE);
         SetAction(ACTION_OVERRIDE_TSEN);
         break;
+    case SETHKPERIOD:
+        pibConfigs.hk_period.Write(pibParam.hkPeriod);
+        snprintf(log_array, LOG_ARRAY_SIZE, "Set hk_period: %u", pibConfigs.hk_period.Read());
+        ZephyrLogFine(log_array);
+        break;
+    case SETRETRYBUDGET:
+        pibConfigs.retry_budget.Write(pibParam.retryBudget);
+        retry.SetBudget(pibConfigs.retry_budget.Read());
+        snprintf(log_array, LOG_ARRAY_SIZE, "Set retry_budget: %u", pibConfigs.retry_budget.Read());
+        ZephyrLogFine(log_array);
+        break;
+    case SETLOGWINDOW:
+        pibConfigs.log_window.Write(pibParam.logWindow);
+        snprintf(log_array, LOG_ARRAY_SIZE, "Set log_window: %u", pibConfigs.log_window.Read());
+        ZephyrLogFine(log_array);
+        break;
+    case SETLORASTATUSPERIOD:
+        pibConfigs.lora_status_period.Write(pibParam.loraStatusPeriod);
+        snprintf(log_array, LOG_ARRAY_SIZE, "Set lora_status_period: %u", pibConfigs.lora_status_period.Read());
+        ZephyrLogFine(log_array);
+        break;
+    case SETLORARADIO:
+        // the PU can't be retuned to match, so only change the PIB radio while docked
+        if (!pibConfigs.pu_docked.Read()) {
+            ZephyrLogWarn("PU undocked, LoRa radio not changed");
+            break;
+        }
+        if (pibParam.loraSF < LORA_SF_MIN || pibParam.loraSF > LORA_SF_MAX) {
+            ZephyrLogWarn("Invalid LoRa spreading factor");
+            break;
+        }
+        pibConfigs.lora_sf.Write(pibParam.loraSF);
+        pibConfigs.lora_bandwidth.Write(pibParam.loraBandwidth);
+        pibConfigs.lora_power.Write(pibParam.loraPower);
+        pibConfigs.lora_margin.Write(pibParam.loraMargin);
+        LoRaApplyRadio();
+        snprintf(log_array, LOG_ARRAY_SIZE, "Set LoRa radio: SF%u, %lu Hz, %u dBm, margin %0.1f dB", pibConfigs.lora_sf.Read(),
+                 pibConfigs.lora_bandwidth.Read(), pibConfigs.lora_power.Read(), pibConfigs.lora_margin.Read());
+        ZephyrLogFine(log_array);
+        break;
+    case SEQUENCECHUNK:
+        if ((uint16_t) pibParam.seqOffset + SEQUENCE_CHUNK > SEQUENCE_SIZE) {
+            ZephyrLogWarn("Sequence chunk out of range");
+            break;
+        }
+        memcpy(&sequence_upload.code[pibParam.seqOffset], pibParam.seqChunk, SEQUENCE_CHUNK);
+        break;
+    case SAVESEQUENCE:
+        sequence_upload.length = pibParam.seqLength;
+        if (!ValidateSequence(sequence_upload, sequence_actions, num_sequence_actions)) {
+            ZephyrLogWarn("Uploaded sequence invalid, not saved");
+            break;
+        }
+        pibConfigs.sequence.Write(sequence_upload);
+        snprintf(log_array, LOG_ARRAY_SIZE, "Saved sequence: %u bytes", pibConfigs.sequence.Read().length);
+        ZephyrLogFine(log_array);
+        break;
+    case RUNSEQUENCE:
+        if (autonomous_mode) {
+            ZephyrLogWarn("Switch to manual mode before running a sequence");
+            break;
+        }
+        SetAction(COMMAND_RUN_SEQUENCE);
+        SetAction(ACTION_OVERRIDE_TSEN);
+        break;
     case STARTREALTIMEMCB:
         if (mcb_motion_ongoing) {
             ZephyrLogWarn("Cannot start real-time MCB mode, motion ongoing");
@@ -340,6 +435,74 @@ void StratoPIB::TCHandler(Telecommand_t telecommand)
         pibConfigs.pu_auto_offload.Write(false);
         ZephyrLogFine("PU data manual offload after manual profile");
         break;
+    case SETTSENPERIOD:
+        if (0 == pibParam.tsenMinPeriod || pibParam.tsenMinPeriod > pibParam.tsenMaxPeriod) {
+            ZephyrLogWarn("Invalid TSEN period bounds");
+            break;
+        }
+        pibConfigs.tsen_min_period.Write(pibParam.tsenMinPeriod);
+        pibConfigs.tsen_max_period.Write(pibParam.tsenMaxPeriod);
+        snprintf(log_array, LOG_ARRAY_SIZE, "Set TSEN period bounds: %u, %u", pibConfigs.tsen_min_period.Read(), pibConfigs.tsen_max_period.Read());
+        ZephyrLogFine(log_array);
+        break;
+    case SETDOCKWINDOW:
+        pibConfigs.dock_window.Write(pibParam.dockWindow);
+        snprintf(log_array, LOG_ARRAY_SIZE, "Set dock_window: %f", pibConfigs.dock_window.Read());
+        ZephyrLogFine(log_array);
+        break;
+    case SETSTALLPARAMS:
+        if (pibParam.stallFraction <= 0.0f || pibParam.stallFraction > 1.0f || 0 == pibParam.stallSamples) {
+            ZephyrLogWarn("Invalid stall parameters");
+            break;
+        }
+        pibConfigs.stall_fraction.Write(pibParam.stallFraction);
+        pibConfigs.stall_samples.Write(pibParam.stallSamples);
+        snprintf(log_array, LOG_ARRAY_SIZE, "Set stall params: %0.2f, %u", pibConfigs.stall_fraction.Read(), pibConfigs.stall_samples.Read());
+        ZephyrLogFine(log_array);
+        break;
+    case SETYOYO:
+        // 0 casts disables yo-yo mode, otherwise the cast top has to sit between the dock and the profile bottom
+        if (0 != pibParam.yoyoCasts && (pibParam.yoyoTop < pibConfigs.dock_amount.Read() || pibParam.yoyoTop >= pibConfigs.profile_size.Read())) {
+            ZephyrLogWarn("Invalid yo-yo top");
+            break;
+        }
+        pibConfigs.yoyo_casts.Write(pibParam.yoyoCasts);
+        pibConfigs.yoyo_top.Write(pibParam.yoyoTop);
+        snprintf(log_array, LOG_ARRAY_SIZE, "Set yo-yo: %u casts, top %0.1f", pibConfigs.yoyo_casts.Read(), pibConfigs.yoyo_top.Read());
+        ZephyrLogFine(log_array);
+        break;
+    case ADDPROFILESTOP:
+        if (pibParam.stopDepth <= pibConfigs.dock_amount.Read() || pibParam.stopDepth >= pibConfigs.profile_size.Read() || pibParam.stopVelocity < 0.0f) {
+            ZephyrLogWarn("Invalid profile stop");
+            break;
+        }
+        if (!AddProfileStop({pibParam.stopDepth, pibParam.stopVelocity, pibParam.stopDwell})) {
+            ZephyrLogWarn("Profile stop table full");
+            break;
+        }
+        snprintf(log_array, LOG_ARRAY_SIZE, "Added profile stop: %0.1f revs, %u s, %u stops", pibParam.stopDepth, pibParam.stopDwell, pibConfigs.profile_stops.Read().num_stops);
+        ZephyrLogFine(log_array);
+        break;
+    case CLEARPROFILESTOPS:
+        pibConfigs.profile_stops.Write(PIBConfigs::EmptyStops());
+        ZephyrLogFine("Cleared profile stops");
+        break;
+    case ADDVELOCITYBAND:
+        if (pibParam.bandTop < 0.0f || pibParam.bandTop >= pibParam.bandBottom || pibParam.bandVelocity <= 0.0f) {
+            ZephyrLogWarn("Invalid velocity band");
+            break;
+        }
+        if (!AddVelocityBand({pibParam.bandTop, pibParam.bandBottom, pibParam.bandVelocity})) {
+            ZephyrLogWarn("Velocity band overlaps another or table full");
+            break;
+        }
+        snprintf(log_array, LOG_ARRAY_SIZE, "Added velocity band: %0.1f to %0.1f revs at %0.1f rpm", pibParam.bandTop, pibParam.bandBottom, pibParam.bandVelocity);
+        ZephyrLogFine(log_array);
+        break;
+    case CLEARVELOCITYBANDS:
+        pibConfigs.velocity_bands.Write(PIBConfigs::EmptyBands());
+        ZephyrLogFine("Cleared velocity bands");
+        break;
 
     // PU Telecommands ------------------------------------
     case LORATXSTATUS:
@@ -410,6 +573,7 @@ void StratoPIB::TCHandler(Telecommand_t telecommand)
 
     // Error case -----------------------------------------
     default:
+        link_stats[LINK_ZEPHYR].unknown_ids++;
         snprintf(log_array, LOG_ARRAY_SIZE, "Unknown TC ID: %u", telecommand);
         ZephyrLogWarn(log_array);
         break;
@@ -0,0 +1,217 @@
+#!/usr/bin/env python3
+#
+#  check_lora_link.py
+#  Author:  Alex St. Clair
+#  Created: October 2026
+#
+#  Benchmarks the LoRa spreading factor recommender (PIBLoRaLink.cpp) against
+#  fixed spreading factors over a simulated relay session. The firmware
+#  source is compiled for the host with the system C++ compiler and called
+#  through ctypes, so the SNR limits, smoothing, hysteresis, and contact
+#  fallback are the code that flies.
+#
+#  The PU drifts out from the PIB to a maximum distance and back over a
+#  12 hour session, sending a status packet every period. The channel is a
+#  log-distance path loss with correlated log-normal shadowing, and a
+#  packet is received if its SNR clears the demodulation limit of the SF it
+#  was sent at. The recommended SF is assumed applied at both ends, with
+#  the PU following the same fallback schedule when contact is lost. Each
+#  strategy sees the same channel, and is scored on packet loss and on
+#  time on air per delivered packet (the cost of a lower data rate).
+#
+#    python3 check_lora_link.py
+#    python3 check_lora_link.py --margin 6 --period 120
+#
+#  Exits non-zero if the recommender loses more packets than the fixed
+#  SF10 it replaces at any distance.
+
+import argparse
+import ctypes
+import math
+import os
+import random
+import subprocess
+import sys
+import tempfile
+
+FREQUENCY = 915e6           # Hz
+BANDWIDTH = 250e3           # Hz, pibConfigs.lora_bandwidth default
+TX_POWER = 14.0             # dBm, pibConfigs.lora_power default
+NOISE_FIGURE = 6.0          # dB, SX127x receiver
+SYSTEM_LOSS = 10.0          # dB, cables, antenna pattern, and polarization
+PATH_EXPONENT = 2.2         # near free space between balloon-borne antennas
+SHADOW_SIGMA = 4.0          # dB
+SHADOW_CORRELATION = 0.8    # between consecutive packets
+SNR_NOISE = 1.0             # dB, error in the radio's SNR estimate
+
+PAYLOAD = 28                # bytes, one parsed "ST" record
+PREAMBLE = 8
+CODING_RATE = 1             # 4/5
+
+SF_MIN = 7
+SF_MAX = 12
+SF_FIXED = 10               # the previous fixed setting
+SNR_LIMITS = {7: -7.5, 8: -10.0, 9: -12.5, 10: -15.0, 11: -17.5, 12: -20.0}
+
+LORA_TM_TIMEOUT = 600
+SESSION = 12 * 3600         # s, out for 4 h, hold for 4 h, back for 4 h
+DISTANCES = (2, 5, 10, 20, 40)  # km, maximum distance of each run
+SEEDS = 10
+
+REPO = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+
+ARDUINO_SHIM = """
+#include <stdint.h>
+"""
+
+WRAPPER = """
+#include "PIBLoRaLink.h"
+static PIBLoRaLink link;
+extern "C" void reset(uint8_t sf, uint32_t now_s) { link.Reset(sf, now_s); }
+extern "C" void packet(int rssi, float snr, uint32_t now_s) { link.Packet(rssi, snr, now_s); }
+extern "C" int update(uint32_t now_s, float margin_db, uint32_t timeout) { return link.Update(now_s, margin_db, timeout); }
+extern "C" uint8_t recommended() { return link.Recommended(); }
+"""
+
+
+def build_firmware():
+    tmp = tempfile.mkdtemp(prefix="lora_")
+    with open(os.path.join(tmp, "Arduino.h"), "w") as f:
+        f.write(ARDUINO_SHIM)
+    with open(os.path.join(tmp, "wrapper.cpp"), "w") as f:
+        f.write(WRAPPER)
+
+    lib = os.path.join(tmp, "liblora.so")
+    subprocess.check_call(["c++", "-O2", "-shared", "-fPIC", "-I", tmp, "-I", REPO,
+                           os.path.join(REPO, "PIBLoRaLink.cpp"), os.path.join(tmp, "wrapper.cpp"), "-o", lib])
+
+    lora = ctypes.CDLL(lib)
+    lora.reset.argtypes = [ctypes.c_uint8, ctypes.c_uint32]
+    lora.packet.argtypes = [ctypes.c_int, ctypes.c_float, ctypes.c_uint32]
+    lora.update.restype = ctypes.c_int
+    lora.update.argtypes = [ctypes.c_uint32, ctypes.c_float, ctypes.c_uint32]
+    lora.recommended.restype = ctypes.c_uint8
+    return lora
+
+
+def time_on_air(sf):
+    # Semtech AN1200.13, explicit header with CRC
+    symbol = (2 ** sf) / BANDWIDTH
+    low_rate = 1 if symbol > 0.016 else 0
+    bits = 8 * PAYLOAD - 4 * sf + 28 + 16
+    symbols = 8 + max(math.ceil(bits / (4.0 * (sf - 2 * low_rate))) * (CODING_RATE + 4), 0)
+    return (PREAMBLE + 4.25 + symbols) * symbol
+
+
+def distance(t, maximum):
+    leg = SESSION / 3.0
+    near = 100.0
+    if t < leg:
+        return near + (maximum - near) * t / leg
+    if t < 2 * leg:
+        return maximum
+    return maximum - (maximum - near) * (t - 2 * leg) / leg
+
+
+def channel(maximum, period, seed):
+    # (time, rssi, snr) for every packet the PU sends
+    rng = random.Random(seed)
+    noise_floor = -174.0 + 10.0 * math.log10(BANDWIDTH) + NOISE_FIGURE
+    reference_loss = 20.0 * math.log10(4.0 * math.pi * FREQUENCY / 299792458.0)
+    innovation = SHADOW_SIGMA * math.sqrt(1.0 - SHADOW_CORRELATION ** 2)
+    shadow = rng.gauss(0.0, SHADOW_SIGMA)
+
+    packets = []
+    for t in range(period, SESSION, period):
+        shadow = SHADOW_CORRELATION * shadow + rng.gauss(0.0, innovation)
+        loss = reference_loss + 10.0 * PATH_EXPONENT * math.log10(distance(t, maximum)) + SYSTEM_LOSS + shadow
+        rssi = TX_POWER - loss
+        packets.append((t, rssi, rssi - noise_floor))
+    return packets
+
+
+def run_fixed(packets, sf):
+    delivered = sum(1 for _, _, snr in packets if snr >= SNR_LIMITS[sf])
+    return delivered, len(packets) * time_on_air(sf), {sf: len(packets)}
+
+
+def run_recommender(lora, packets, margin, timeout, seed):
+    rng = random.Random(seed + 1)
+    lora.reset(SF_FIXED, 0)
+    sf = SF_FIXED
+    delivered = 0
+    airtime = 0.0
+    usage = {}
+    arrivals = iter(packets)
+    pending = next(arrivals, None)
+
+    for now in range(SESSION):
+        if pending and pending[0] == now:
+            _, rssi, snr = pending
+            airtime += time_on_air(sf)
+            usage[sf] = usage.get(sf, 0) + 1
+            if snr >= SNR_LIMITS[sf]:
+                delivered += 1
+                lora.packet(int(round(rssi)), snr + rng.gauss(0.0, SNR_NOISE), now)
+            pending = next(arrivals, None)
+
+        # CheckLoRaLink runs every loop, once a second is plenty here
+        if lora.update(now, margin, timeout):
+            sf = lora.recommended()
+
+    return delivered, airtime, usage
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Benchmark the LoRa SF recommender")
+    parser.add_argument("--margin", type=float, default=10.0, help="pibConfigs.lora_margin (dB)")
+    parser.add_argument("--period", type=int, default=60, help="PU status period, lora_tx_status (s)")
+    args = parser.parse_args()
+
+    lora = build_firmware()
+    timeout = max(2 * args.period, LORA_TM_TIMEOUT)
+    strategies = ["SF{}".format(sf) for sf in range(SF_MIN, SF_MAX + 1)] + ["recommended"]
+
+    print("margin {:.1f} dB, status every {} s, contact timeout {} s, {} seeds per distance".format(
+        args.margin, args.period, timeout, SEEDS))
+    print("time on air per packet: " + ", ".join("SF{} {:.0f} ms".format(sf, 1000 * time_on_air(sf))
+                                                  for sf in range(SF_MIN, SF_MAX + 1)))
+    print()
+    print("{:>6}  {:>12}  ".format("km", "") + "  ".join("{:>11}".format(s) for s in strategies))
+
+    failed = False
+    for maximum in DISTANCES:
+        totals = {s: [0, 0, 0.0] for s in strategies}  # sent, delivered, airtime
+        usage = {}
+        for seed in range(SEEDS):
+            packets = channel(1000.0 * maximum, args.period, seed)
+            for sf in range(SF_MIN, SF_MAX + 1):
+                delivered, airtime, _ = run_fixed(packets, sf)
+                totals["SF{}".format(sf)][0] += len(packets)
+                totals["SF{}".format(sf)][1] += delivered
+                totals["SF{}".format(sf)][2] += airtime
+            delivered, airtime, used = run_recommender(lora, packets, args.margin, timeout, seed)
+            totals["recommended"][0] += len(packets)
+            totals["recommended"][1] += delivered
+            totals["recommended"][2] += airtime
+            for sf, count in used.items():
+                usage[sf] = usage.get(sf, 0) + count
+
+        loss = {s: 100.0 * (1.0 - float(t[1]) / t[0]) for s, t in totals.items()}
+        cost = {s: (1000.0 * t[2] / t[1]) if t[1] else float("inf") for s, t in totals.items()}
+        print("{:>6}  {:>12}  ".format(maximum, "loss %") + "  ".join("{:>11.1f}".format(loss[s]) for s in strategies))
+        print("{:>6}  {:>12}  ".format("", "ms/delivered") + "  ".join("{:>11.0f}".format(cost[s]) for s in strategies))
+        sent = float(sum(usage.values()))
+        print("{:>6}  {:>12}  ".format("", "SF use") + ", ".join("SF{} {:.0f}%".format(sf, 100.0 * usage[sf] / sent)
+                                                                 for sf in sorted(usage)))
+
+        if loss["recommended"] > loss["SF{}".format(SF_FIXED)] + 0.05:
+            failed = True
+
+    print()
+    print("FAIL" if failed else "PASS")
+    sys.exit(1 if failed else 0)
+
+
+if __name__ == "__main__":
+    main()
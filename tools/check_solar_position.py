@@ -0,0 +1,296 @@
+#!/usr/bin/env python3
+#
+#  check_solar_position.py
+#  Author:  Alex St. Clair
+#  Created: October 2026
+#
+#  Checks the onboard ephemeris (SolarPosition.cpp) against a reference
+#  along a flight track. The firmware source is compiled for the host with
+#  the system C++ compiler and called through ctypes, so the single
+#  precision arithmetic is the same code that flies.
+#
+#  The reference is the abridged VSOP87 solution for the Earth (as tabulated
+#  in Meeus, Astronomical Algorithms, and the NREL SPA), with the leading
+#  IAU 1980 nutation terms, aberration, and apparent sidereal time, in
+#  double precision. It is good to about 0.0003 degrees, and is itself
+#  checked against the published SPA example before use. Both give the
+#  geocentric zenith angle with no refraction.
+#
+#  With no track file, a synthetic long-duration flight is used: an
+#  equatorial drift from the Seychelles, one point every 10 minutes for 30
+#  days. A track file has one "epoch,latitude,longitude" line per point:
+#
+#    python3 check_solar_position.py
+#    python3 check_solar_position.py track.csv
+#
+#  Exits non-zero if either tolerance below is exceeded.
+
+import ctypes
+import math
+import os
+import subprocess
+import sys
+import tempfile
+
+SZA_TOLERANCE = 0.02        # degrees
+CROSSING_TOLERANCE = 15     # seconds, the bisection resolution is 10 s
+
+SZA_MINIMUM = 105.0         # pibConfigs.sza_minimum default
+SZA_PREDICT_HORIZON = 43200
+DARK_PREDICT_HORIZON = 86400
+DELTA_T = 69.0              # TT - UT (s) for 2026
+
+REPO = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+
+ARDUINO_SHIM = """
+#include <stdint.h>
+#include <math.h>
+#define DEG_TO_RAD 0.017453292519943295769236907684886
+#define RAD_TO_DEG 57.295779513082320876798154814105
+"""
+
+WRAPPER = """
+#include "SolarPosition.h"
+extern "C" float sza(uint32_t epoch, float lat, float lon) { return SolarZenith(epoch, lat, lon); }
+extern "C" uint32_t crossing(uint32_t start, float lat, float lon, float sza, uint32_t horizon, int rising)
+{
+    return PredictSZACrossing(start, lat, lon, sza, horizon, 0 != rising);
+}
+"""
+
+
+def build_firmware():
+    tmp = tempfile.mkdtemp(prefix="solar_")
+    with open(os.path.join(tmp, "Arduino.h"), "w") as f:
+        f.write(ARDUINO_SHIM)
+    with open(os.path.join(tmp, "wrapper.cpp"), "w") as f:
+        f.write(WRAPPER)
+
+    lib = os.path.join(tmp, "libsolar.so")
+    subprocess.check_call(["c++", "-O2", "-shared", "-fPIC", "-ffp-contract=off", "-I", tmp, "-I", REPO,
+                           os.path.join(REPO, "SolarPosition.cpp"), os.path.join(tmp, "wrapper.cpp"), "-o", lib])
+
+    solar = ctypes.CDLL(lib)
+    solar.sza.restype = ctypes.c_float
+    solar.sza.argtypes = [ctypes.c_uint32, ctypes.c_float, ctypes.c_float]
+    solar.crossing.restype = ctypes.c_uint32
+    solar.crossing.argtypes = [ctypes.c_uint32, ctypes.c_float, ctypes.c_float, ctypes.c_float, ctypes.c_uint32, ctypes.c_int]
+    return solar
+
+
+# abridged VSOP87 Earth series: (A, B, C) terms of A cos(B + C tau), tau in Julian millennia
+L_TERMS = [
+    [(175347046, 0, 0), (3341656, 4.6692568, 6283.07585), (34894, 4.6261, 12566.1517), (3497, 2.7441, 5753.3849),
+     (3418, 2.8289, 3.5231), (3136, 3.6277, 77713.7715), (2676, 4.4181, 7860.4194), (2343, 6.1352, 3930.2097),
+     (1324, 0.7425, 11506.7698), (1273, 2.0371, 529.691), (1199, 1.1096, 1577.3435), (990, 5.233, 5884.927),
+     (902, 2.045, 26.298), (857, 3.508, 398.149), (780, 1.179, 5223.694), (753, 2.533, 5507.553),
+     (505, 4.583, 18849.228), (492, 4.205, 775.523), (357, 2.92, 0.067), (317, 5.849, 11790.629),
+     (284, 1.899, 796.298), (271, 0.315, 10977.079), (243, 0.345, 5486.778), (206, 4.806, 2544.314),
+     (205, 1.869, 5573.143), (202, 2.458, 6069.777), (156, 0.833, 213.299), (132, 3.411, 2942.463),
+     (126, 1.083, 20.775), (115, 0.645, 0.98), (103, 0.636, 4694.003), (102, 0.976, 15720.839),
+     (102, 4.267, 7.114), (99, 6.21, 2146.17), (98, 0.68, 155.42), (86, 5.98, 161000.69),
+     (85, 1.3, 6275.96), (85, 3.67, 71430.7), (80, 1.81, 17260.15), (79, 3.04, 12036.46),
+     (75, 1.76, 5088.63), (74, 3.5, 3154.69), (74, 4.68, 801.82), (70, 0.83, 9437.76),
+     (62, 3.98, 8827.39), (61, 1.82, 7084.9), (57, 2.78, 6286.6), (56, 4.39, 14143.5),
+     (56, 3.47, 6279.55), (52, 0.19, 12139.55), (52, 1.33, 1748.02), (51, 0.28, 5856.48),
+     (49, 0.49, 1194.45), (41, 5.37, 8429.24), (41, 2.4, 19651.05), (39, 6.17, 10447.39),
+     (37, 6.04, 10213.29), (37, 2.57, 1059.38), (36, 1.71, 2352.87), (36, 1.78, 6812.77),
+     (33, 0.59, 17789.85), (30, 0.44, 83996.85), (30, 2.74, 1349.87), (25, 3.16, 4690.48)],
+    [(628331966747, 0, 0), (206059, 2.678235, 6283.07585), (4303, 2.6351, 12566.1517), (425, 1.59, 3.523),
+     (119, 5.796, 26.298), (109, 2.966, 1577.344), (93, 2.59, 18849.23), (72, 1.14, 529.69),
+     (68, 1.87, 398.15), (67, 4.41, 5507.55), (59, 2.89, 5223.69), (56, 2.17, 155.42),
+     (45, 0.4, 796.3), (36, 0.47, 775.52), (29, 2.65, 7.11), (21, 5.34, 0.98),
+     (19, 1.85, 5486.78), (19, 4.97, 213.3), (17, 2.99, 6275.96), (16, 0.03, 2544.31),
+     (16, 1.43, 2146.17), (15, 1.21, 10977.08), (12, 2.83, 1748.02), (12, 3.26, 5088.63),
+     (12, 5.27, 1194.45), (12, 2.08, 4694), (11, 0.77, 553.57), (10, 1.3, 6286.6),
+     (10, 4.24, 1349.87), (9, 2.7, 242.73), (9, 5.64, 951.72), (8, 5.3, 2352.87),
+     (6, 2.65, 9437.76), (6, 4.67, 4690.48)],
+    [(52919, 0, 0), (8720, 1.0721, 6283.0758), (309, 0.867, 12566.152), (27, 0.05, 3.52),
+     (16, 5.19, 26.3), (16, 3.68, 155.42), (10, 0.76, 18849.23), (9, 2.06, 77713.77),
+     (7, 0.83, 775.52), (5, 4.66, 1577.34), (4, 1.03, 7.11), (4, 3.44, 5573.14),
+     (3, 5.14, 796.3), (3, 6.05, 5507.55), (3, 1.19, 242.73), (3, 6.12, 529.69),
+     (3, 0.31, 398.15), (3, 2.28, 553.57), (2, 4.38, 5223.69), (2, 3.75, 0.98)],
+    [(289, 5.844, 6283.076), (35, 0, 0), (17, 5.49, 12566.15), (3, 5.2, 155.42),
+     (1, 4.72, 3.52), (1, 5.3, 18849.23), (1, 5.97, 242.73)],
+    [(114, 3.142, 0), (8, 4.13, 6283.08), (1, 3.84, 12566.15)],
+    [(1, 3.14, 0)],
+]
+
+B_TERMS = [
+    [(280, 3.199, 84334.662), (102, 5.422, 5507.553), (80, 3.88, 5223.69), (44, 3.7, 2352.87), (32, 4, 1577.34)],
+    [(9, 3.9, 5507.55), (6, 1.73, 5223.69)],
+]
+
+R_TERMS = [
+    [(100013989, 0, 0), (1670700, 3.0984635, 6283.07585), (13956, 3.05525, 12566.1517), (3084, 5.1985, 77713.7715),
+     (1628, 1.1739, 5753.3849), (1576, 2.8469, 7860.4194), (925, 5.453, 11506.77), (542, 4.564, 3930.21),
+     (472, 3.661, 5884.927), (346, 0.964, 5507.553), (329, 5.9, 5223.694), (307, 0.299, 5573.143),
+     (243, 4.273, 11790.629), (212, 5.847, 1577.344), (186, 5.022, 10977.079), (175, 3.012, 18849.228),
+     (110, 5.055, 5486.778), (98, 0.89, 6069.78), (86, 5.69, 15720.84), (86, 1.27, 161000.69),
+     (65, 0.27, 17260.15), (63, 0.92, 529.69), (57, 2.01, 83996.85), (56, 5.24, 71430.7),
+     (49, 3.25, 2544.31), (47, 2.58, 775.52), (45, 5.54, 9437.76), (43, 6.01, 6275.96),
+     (39, 5.36, 4694), (38, 2.39, 8827.39), (37, 0.83, 19651.05), (37, 4.9, 12139.55),
+     (36, 1.67, 12036.46), (35, 1.84, 2942.46), (33, 0.24, 7084.9), (32, 0.18, 5088.63),
+     (32, 1.78, 398.15), (28, 1.21, 6286.6), (28, 1.9, 6279.55), (26, 4.59, 10447.39)],
+    [(103019, 1.10749, 6283.07585), (1721, 1.0644, 12566.1517), (702, 3.142, 0), (32, 1.02, 18849.23),
+     (31, 2.84, 5507.55), (25, 1.32, 5223.69), (18, 1.42, 1577.34), (10, 5.91, 10977.08),
+     (9, 1.42, 6275.96), (9, 0.27, 5486.78)],
+    [(4359, 5.7846, 6283.0758), (124, 5.579, 12566.152), (12, 3.14, 0), (9, 3.63, 77713.77),
+     (6, 1.87, 5573.14), (3, 5.47, 18849.23)],
+    [(145, 4.273, 6283.076), (7, 3.92, 12566.15)],
+    [(4, 2.56, 6283.08)],
+]
+
+
+def series(terms, tau):
+    total = 0.0
+    for power, row in enumerate(terms):
+        total += sum(a * math.cos(b + c * tau) for a, b, c in row) * tau ** power
+    return total / 1e8
+
+
+def reference_position(epoch, delta_t=DELTA_T):
+    """Apparent geocentric right ascension and declination (degrees), and apparent sidereal time."""
+    jd = epoch / 86400.0 + 2440587.5
+    jde = jd + delta_t / 86400.0
+    t = (jde - 2451545.0) / 36525.0
+    tau = t / 10.0
+
+    helio_long = math.degrees(series(L_TERMS, tau)) % 360.0
+    helio_lat = math.degrees(series(B_TERMS, tau))
+    radius = series(R_TERMS, tau)
+
+    geo_long = (helio_long + 180.0) % 360.0
+    geo_lat = -helio_lat
+
+    # leading nutation terms (arcseconds), good to about half an arcsecond
+    omega = math.radians(125.04452 - 1934.136261 * t)
+    sun_long = math.radians(280.4665 + 36000.7698 * t)
+    moon_long = math.radians(218.3165 + 481267.8813 * t)
+    nut_long = (-17.20 * math.sin(omega) - 1.32 * math.sin(2 * sun_long) - 0.23 * math.sin(2 * moon_long)
+                + 0.21 * math.sin(2 * omega)) / 3600.0
+    nut_obliq = (9.20 * math.cos(omega) + 0.57 * math.cos(2 * sun_long) + 0.10 * math.cos(2 * moon_long)
+                 - 0.09 * math.cos(2 * omega)) / 3600.0
+
+    mean_obliq = 23.0 + 26.0 / 60.0 + (21.448 - 46.8150 * t - 0.00059 * t * t + 0.001813 * t ** 3) / 3600.0
+    obliq = math.radians(mean_obliq + nut_obliq)
+
+    app_long = math.radians(geo_long + nut_long - 20.4898 / (3600.0 * radius))
+    beta = math.radians(geo_lat)
+
+    ra = math.degrees(math.atan2(math.sin(app_long) * math.cos(obliq) - math.tan(beta) * math.sin(obliq),
+                                 math.cos(app_long))) % 360.0
+    decl = math.degrees(math.asin(math.sin(beta) * math.cos(obliq)
+                                  + math.cos(beta) * math.sin(obliq) * math.sin(app_long)))
+
+    tu = (jd - 2451545.0) / 36525.0
+    gmst = 280.46061837 + 360.98564736629 * (jd - 2451545.0) + 0.000387933 * tu * tu - tu ** 3 / 38710000.0
+    gast = (gmst + nut_long * math.cos(obliq)) % 360.0
+
+    return ra, decl, gast
+
+
+def reference_zenith(epoch, latitude, longitude):
+    ra, decl, gast = reference_position(epoch)
+    hour_angle = math.radians(gast + longitude - ra)
+    lat = math.radians(latitude)
+    decl = math.radians(decl)
+    cos_zenith = math.sin(lat) * math.sin(decl) + math.cos(lat) * math.cos(decl) * math.cos(hour_angle)
+    return math.degrees(math.acos(max(-1.0, min(1.0, cos_zenith))))
+
+
+def check_reference():
+    # NREL SPA (Reda and Andreas, 2004) example: 2003-10-17 19:30:30 UT, delta T 67 s, 39.742476 N 105.1786 W
+    epoch = 1066419030
+    ra, decl, gast = reference_position(epoch, 67.0)
+    hour_angle = (gast - 105.1786 - ra) % 360.0
+    errors = (abs(ra - 202.22741), abs(decl - (-9.31434)), abs(hour_angle - 11.105900))
+    if max(errors) > 0.0005:
+        sys.exit("reference fails the SPA example: RA {:.5f}, dec {:.5f}, H {:.5f}".format(ra, decl, hour_angle))
+
+
+def reference_crossing(start, latitude, longitude, sza, horizon, rising):
+    """Crossing time to 0.1 s, scanning at one minute so no crossing found by the firmware is missed."""
+    before = start
+    was_above = reference_zenith(start, latitude, longitude) >= sza
+    for offset in range(60, horizon + 60, 60):
+        after = start + offset
+        above = reference_zenith(after, latitude, longitude) >= sza
+        if above != was_above and above == rising:
+            lo, hi = float(before), float(after)
+            while hi - lo > 0.1:
+                mid = (lo + hi) / 2
+                if (reference_zenith(mid, latitude, longitude) >= sza) == rising:
+                    hi = mid
+                else:
+                    lo = mid
+            return hi
+        before, was_above = after, above
+    return None
+
+
+def synthetic_track():
+    # equatorial long-duration flight: launch from Mahe 2026-11-01 00:00 UTC, drifting east about 8 degrees per day
+    start = 1793491200
+    for i in range(30 * 144):
+        days = i / 144.0
+        latitude = -4.6 + 6.0 * math.sin(2 * math.pi * days / 11.0)
+        longitude = (55.5 + 8.0 * days + 180.0) % 360.0 - 180.0
+        yield start + 600 * i, latitude, longitude
+
+
+def file_track(path):
+    with open(path) as f:
+        for line in f:
+            fields = line.strip().split(",")
+            if len(fields) == 3 and not line.startswith("#"):
+                yield int(fields[0]), float(fields[1]), float(fields[2])
+
+
+def main():
+    check_reference()
+    solar = build_firmware()
+    track = list(file_track(sys.argv[1]) if len(sys.argv) > 1 else synthetic_track())
+
+    # zenith angle at every point
+    worst = (0.0, None)
+    sum_sq = 0.0
+    for epoch, lat, lon in track:
+        error = solar.sza(epoch, lat, lon) - reference_zenith(epoch, lat, lon)
+        sum_sq += error * error
+        if abs(error) > abs(worst[0]):
+            worst = (error, (epoch, lat, lon))
+    rms = math.sqrt(sum_sq / len(track))
+
+    print("{} track points".format(len(track)))
+    print("SZA error: max {:+.4f} deg at {}, rms {:.4f} deg".format(worst[0], worst[1], rms))
+
+    # predicted crossings from every sixth point (hourly on the synthetic track), at that point's position
+    crossing_worst = {True: (0.0, None), False: (0.0, None)}
+    missed = 0
+    for epoch, lat, lon in track[::6]:
+        for rising, horizon in ((True, SZA_PREDICT_HORIZON), (False, DARK_PREDICT_HORIZON)):
+            predicted = solar.crossing(epoch, lat, lon, SZA_MINIMUM, horizon, rising)
+            expected = reference_crossing(epoch, lat, lon, SZA_MINIMUM, horizon, rising)
+            if expected is None or 0 == predicted:
+                # a crossing within a step of the horizon may fall either side of it
+                if (expected is None) != (0 == predicted) and not (expected and expected > epoch + horizon - 300):
+                    missed += 1
+                continue
+            error = predicted - expected
+            if abs(error) > abs(crossing_worst[rising][0]):
+                crossing_worst[rising] = (error, (epoch, lat, lon))
+
+    for rising, name in ((True, "dusk"), (False, "dawn")):
+        print("{} crossing of {:.0f} deg: max error {:+.1f} s at {}".format(name, SZA_MINIMUM, crossing_worst[rising][0],
+                                                                        crossing_worst[rising][1]))
+    print("crossings missed or spurious: {}".format(missed))
+
+    failed = abs(worst[0]) > SZA_TOLERANCE or missed
+    failed = failed or max(abs(crossing_worst[r][0]) for r in (True, False)) > CROSSING_TOLERANCE
+    print("FAIL" if failed else "PASS")
+    sys.exit(1 if failed else 0)
+
+
+if __name__ == "__main__":
+    main()
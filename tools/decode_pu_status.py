@@ -0,0 +1,39 @@
+#!/usr/bin/env python3
+#
+#  decode_pu_status.py
+#  Author:  Alex St. Clair
+#  Created: October 2026
+#
+#  Decodes the packed PU status block (see AddPUStatusTM in StratoPIB.cpp)
+#  at the end of a PU TSEN, profile record, or status TM payload. Pass one
+#  or more files, each holding one TM's binary payload:
+#
+#    python3 decode_pu_status.py tm_payload.bin
+
+import struct
+import sys
+
+BLOCK_SIZE = 22
+FIELDS = ("time", "v_battery", "i_charge", "therm1", "therm2", "heater_stat")
+
+
+def decode(payload):
+    if len(payload) < BLOCK_SIZE:
+        raise ValueError("payload shorter than the status block")
+
+    block = payload[-BLOCK_SIZE:]
+    if block[0] != 1:
+        raise ValueError("unknown PU status version {}".format(block[0]))
+
+    return dict(zip(FIELDS, struct.unpack(">IffffB", block[1:])))
+
+
+def main():
+    for name in sys.argv[1:]:
+        with open(name, "rb") as f:
+            status = decode(f.read())
+        print("{}: PU status: {time}, {v_battery:0.2f}, {i_charge:0.2f}, {therm1:0.2f}, {therm2:0.2f}, {heater_stat}".format(name, **status))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,78 @@
+#!/usr/bin/env python3
+#
+#  decode_trace.py
+#  Author:  Alex St. Clair
+#  Created: October 2026
+#
+#  Decodes the tokenized trace lines (see PIBTrace.h) in captured PIB debug
+#  output. Trace lines are rendered as text, and every other line is passed
+#  through unchanged:
+#
+#    python3 decode_trace.py debug_capture.txt
+#    cat /dev/ttyACM0 | python3 decode_trace.py
+
+import struct
+import sys
+
+# token: (format, argument types), kept in sync with TraceToken_t
+#   u: unsigned, i: signed, f: float bits, h: header bytes (big-endian u32, shown as text)
+FORMATS = {
+    0: ("Trace dropped {} records", "u"),
+    1: ("Reel position: {}", "i"),
+    2: ("PU TSEN: {}, {:0.2f}, {:0.2f}, {:0.2f}, {:0.2f}, {}", "uffffu"),
+    3: ("PU Prof. Rec. {}.{}: {}, {:0.2f}, {:0.2f}, {:0.2f}, {:0.2f}, {}", "Puffff"),
+    4: ("LoRa packet: RSSI {}, {} bytes, header '{}{}'", "iuhh"),
+    5: ("LoRa TM buffer index: {}", "u"),
+}
+
+
+def convert(kind, raw):
+    if kind == "i":
+        return struct.unpack(">i", struct.pack(">I", raw))[0]
+    if kind == "f":
+        return struct.unpack(">f", struct.pack(">I", raw))[0]
+    if kind == "h":
+        text = struct.pack(">I", raw).rstrip(b"\x00")
+        return "".join(chr(b) if 32 <= b < 127 else "." for b in text)
+    return raw
+
+
+def decode(line):
+    fields = line.split()
+    if len(fields) < 3 or fields[0] != "TR":
+        return line
+
+    try:
+        ms = int(fields[1], 16)
+        token = int(fields[2], 16)
+        raw = [int(f, 16) for f in fields[3:]]
+    except ValueError:
+        return line
+
+    if token not in FORMATS:
+        return "[{:10.3f}] unknown trace token {}: {}".format(ms / 1000.0, token, " ".join(fields[3:]))
+
+    fmt, kinds = FORMATS[token]
+    raw += [0] * (len(kinds) - len(raw))  # trailing zero arguments aren't sent
+
+    args = []
+    for kind, value in zip(kinds, raw):
+        if kind == "P":
+            # profile_id << 16 | packet << 8 | heater_stat, heater is rendered last
+            args += [value >> 16, (value >> 8) & 0xFF]
+        else:
+            args.append(convert(kind, value))
+    if "P" in kinds:
+        args.append(raw[kinds.index("P")] & 0xFF)
+
+    return "[{:10.3f}] {}".format(ms / 1000.0, fmt.format(*args))
+
+
+def main():
+    source = open(sys.argv[1], errors="replace") if len(sys.argv) > 1 else sys.stdin
+    for line in source:
+        print(decode(line.rstrip("\r\n")))
+
+
+if __name__ == "__main__":
+    main()